@@ -0,0 +1,248 @@
+// Host implementation of the Arduino core subset declared in sim/include/Arduino.h
+#include <Arduino.h>
+#include <sim.hpp>
+
+#include <cstdarg>
+
+HardwareSerial Serial;
+
+// --- Virtual clock ---
+
+unsigned long millis() { return (unsigned long)(sim::nowUs() / 1000); }
+unsigned long micros() { return (unsigned long)sim::nowUs(); }
+void delay(unsigned long ms) { sim::advanceUs((uint64_t)ms * 1000); }
+void delayMicroseconds(unsigned int us) { sim::advanceUs(us); }
+void yield() {}
+
+// --- GPIO / ADC / PWM ---
+
+#define LEDC_CHANNELS 16
+
+static uint8_t ledcPins[LEDC_CHANNELS]; // Pin attached to each channel, 0 if none
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) { sim::setPinLevel(pin, value); }
+int digitalRead(uint8_t pin) { return sim::pinLevel(pin); }
+int analogRead(uint8_t pin) { return sim::analogLevel(pin); }
+void analogWrite(uint8_t pin, int value) { sim::setPinLevel(pin, value); }
+
+uint32_t ledcSetup(uint8_t channel, uint32_t freq, uint8_t resolution)
+{
+    (void)channel;
+    (void)resolution;
+    return freq;
+}
+
+void ledcAttachPin(uint8_t pin, uint8_t channel)
+{
+    if (channel < LEDC_CHANNELS)
+    {
+        ledcPins[channel] = pin;
+    }
+}
+
+void ledcWrite(uint8_t channel, uint32_t duty)
+{
+    if (channel < LEDC_CHANNELS && ledcPins[channel])
+    {
+        sim::setPinLevel(ledcPins[channel], duty);
+    }
+}
+
+// The pin level reads back as the tone frequency while the tone plays. Like the ESP32
+// core, tone() returns at once; the tone ends after `duration` on the virtual clock.
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration)
+{
+    static uint64_t toneGeneration[256];
+    sim::setPinLevel(pin, frequency);
+    uint64_t generation = ++toneGeneration[pin];
+    if (duration > 0)
+    {
+        sim::schedule(sim::nowUs() + (uint64_t)duration * 1000, [pin, generation]() {
+            if (toneGeneration[pin] == generation)
+            {
+                sim::setPinLevel(pin, 0);
+            }
+        });
+    }
+}
+
+void noTone(uint8_t pin) { sim::setPinLevel(pin, 0); }
+
+// --- String ---
+
+std::atomic<unsigned long> String::allocations_(0);
+
+String::String(float value, unsigned char decimals) : String((double)value, decimals) {}
+
+String::String(double value, unsigned char decimals)
+{
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+    s_ = buffer;
+    allocated();
+}
+
+std::string String::toBase(unsigned long value, unsigned char base)
+{
+    if (base < 2 || base > 36)
+    {
+        base = 10;
+    }
+    char buffer[8 * sizeof(long) + 1];
+    char *p = buffer + sizeof(buffer) - 1;
+    *p = '\0';
+    do
+    {
+        unsigned digit = value % base;
+        *--p = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        value /= base;
+    } while (value);
+    return p;
+}
+
+std::string String::toBase(long value, unsigned char base)
+{
+    if (value < 0 && base == 10)
+    {
+        return "-" + toBase((unsigned long)(-value), base);
+    }
+    return toBase((unsigned long)value, base);
+}
+
+void String::toUpperCase()
+{
+    for (char &c : s_)
+    {
+        c = toupper((unsigned char)c);
+    }
+}
+
+void String::toLowerCase()
+{
+    for (char &c : s_)
+    {
+        c = tolower((unsigned char)c);
+    }
+}
+
+void String::trim()
+{
+    size_t begin = s_.find_first_not_of(" \t\r\n");
+    size_t end = s_.find_last_not_of(" \t\r\n");
+    s_ = begin == std::string::npos ? std::string() : s_.substr(begin, end - begin + 1);
+}
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+    if (from > to)
+    {
+        std::swap(from, to);
+    }
+    if (from >= s_.size())
+    {
+        return String();
+    }
+    return String(s_.substr(from, to - from));
+}
+
+int String::indexOf(char c, unsigned int from) const
+{
+    size_t pos = s_.find(c, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+// --- Print ---
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--)
+    {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::print(long value, int base)
+{
+    char buffer[8 * sizeof(long) + 2];
+    if (base == 10)
+    {
+        snprintf(buffer, sizeof(buffer), "%ld", value);
+        return write(buffer);
+    }
+    return print((unsigned long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+    if (base == 10)
+    {
+        char buffer[8 * sizeof(long) + 1];
+        snprintf(buffer, sizeof(buffer), "%lu", value);
+        return write(buffer);
+    }
+    return print(String(value, (unsigned char)base));
+}
+
+size_t Print::print(double value, int digits)
+{
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+    return write(buffer);
+}
+
+size_t Print::printf(const char *format, ...)
+{
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length < 0)
+    {
+        return 0;
+    }
+    return write((const uint8_t *)buffer, std::min((size_t)length, sizeof(buffer) - 1));
+}
+
+// --- Serial ---
+
+size_t HardwareSerial::write(uint8_t c) { return write(&c, 1); }
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    bytesWritten_ += size;
+    if (output_)
+    {
+        fwrite(buffer, 1, size, output_);
+    }
+    return size;
+}
+
+int HardwareSerial::available() { return (int)(rx_.size() - rxPos_); }
+
+int HardwareSerial::read()
+{
+    if (rxPos_ >= rx_.size())
+    {
+        return -1;
+    }
+    int c = (uint8_t)rx_[rxPos_++];
+    if (rxPos_ == rx_.size())
+    {
+        rx_.clear();
+        rxPos_ = 0;
+    }
+    return c;
+}
+
+int HardwareSerial::peek() { return rxPos_ < rx_.size() ? (uint8_t)rx_[rxPos_] : -1; }
+
+void HardwareSerial::inject(const char *data, size_t size) { rx_.append(data, size); }
@@ -0,0 +1,380 @@
+// MFRC522, DS1302 and DHT models, and the SPI bus they hang off
+#include <DHT.h>
+#include <MFRC522.h>
+#include <RtcDS1302.h>
+#include <SPI.h>
+#include <sim.hpp>
+
+#include <map>
+
+SPIClass SPI;
+
+// --- MFRC522 ---
+
+// Costs of the library's reader calls. Every command is framed by a handful of 4 MHz SPI
+// register accesses; a command the card does not answer runs into the 25 ms receive
+// timeout that PCD_Init programs into the reader's timer.
+#define MFRC522_COMMAND_US 150
+#define MFRC522_TIMEOUT_US 25000
+#define MFRC522_ATQA_US 250     // REQA and the card's answer
+#define MFRC522_CASCADE_US 1200 // ANTICOLLISION and SELECT for one cascade level
+
+// ISO 14443-3 card states
+enum cardState
+{
+    CARD_IDLE,
+    CARD_READY,
+    CARD_ACTIVE,
+    CARD_HALT
+};
+
+struct antenna
+{
+    bool present = false;
+    uint64_t removeAtUs = 0;
+    uint8_t uid[10];
+    uint8_t size = 0;
+    cardState state = CARD_IDLE;
+    sim::ReaderStats stats = {0, 0, 0, 0};
+};
+
+static std::map<uint8_t, antenna> antennas;
+
+// Function to return the antenna on `pin`, taking away a card whose hold time is over
+static antenna &antennaAt(uint8_t pin)
+{
+    antenna &field = antennas[pin];
+    if (field.present && sim::nowUs() >= field.removeAtUs)
+    {
+        field.present = false;
+    }
+    return field;
+}
+
+MFRC522::MFRC522(byte chipSelectPin, byte resetPowerDownPin)
+    : chipSelectPin_(chipSelectPin), resetPowerDownPin_(resetPowerDownPin)
+{
+    memset(&uid, 0, sizeof(uid));
+}
+
+MFRC522::MFRC522() : MFRC522(UNUSED_PIN, UNUSED_PIN) {}
+
+void MFRC522::PCD_Init()
+{
+    delay(50); // Hard reset and oscillator start-up
+}
+
+void MFRC522::PCD_Init(byte chipSelectPin, byte resetPowerDownPin)
+{
+    chipSelectPin_ = chipSelectPin;
+    resetPowerDownPin_ = resetPowerDownPin;
+    PCD_Init();
+}
+
+bool MFRC522::PICC_IsNewCardPresent()
+{
+    sim::advanceUs(MFRC522_COMMAND_US);
+    antenna &field = antennaAt(chipSelectPin_);
+    field.stats.polls++;
+
+    if (field.present && field.state == CARD_IDLE)
+    {
+        sim::advanceUs(MFRC522_ATQA_US);
+        field.state = CARD_READY;
+        return true;
+    }
+
+    // A selected card does not answer REQA; the unexpected command drops it back to idle,
+    // which is why an unhalted card is found again on the next poll
+    if (field.present && field.state != CARD_HALT)
+    {
+        field.state = CARD_IDLE;
+    }
+    sim::advanceUs(MFRC522_TIMEOUT_US);
+    return false;
+}
+
+bool MFRC522::PICC_ReadCardSerial()
+{
+    sim::advanceUs(MFRC522_COMMAND_US);
+    antenna &field = antennaAt(chipSelectPin_);
+    if (!field.present || field.state != CARD_READY)
+    {
+        sim::advanceUs(MFRC522_TIMEOUT_US);
+        return false;
+    }
+
+    uint8_t cascadeLevels = field.size <= 4 ? 1 : field.size <= 7 ? 2 : 3;
+    sim::advanceUs(cascadeLevels * MFRC522_CASCADE_US);
+    uid.size = field.size;
+    memcpy(uid.uidByte, field.uid, field.size);
+    uid.sak = 0x08; // MIFARE Classic 1K
+    field.state = CARD_ACTIVE;
+    field.stats.reads++;
+    field.stats.lastReadUs = sim::nowUs();
+    return true;
+}
+
+// HLTA is never answered, so the library always waits out the receive timeout
+MFRC522::StatusCode MFRC522::PICC_HaltA()
+{
+    sim::advanceUs(MFRC522_COMMAND_US + MFRC522_TIMEOUT_US);
+    antenna &field = antennaAt(chipSelectPin_);
+    field.stats.halts++;
+    if (field.present && field.state == CARD_ACTIVE)
+    {
+        field.state = CARD_HALT;
+    }
+    return STATUS_OK;
+}
+
+void MFRC522::PCD_StopCrypto1() { sim::advanceUs(10); }
+
+// --- DS1302 ---
+
+#define DS1302_BURST_US 250   // Command byte and the 8 byte clock burst at ~3 us per bit
+#define DS1302_REGISTER_US 60 // Command byte and one register
+
+static uint32_t rtcBaseSeconds = 0; // Time set at rtcBaseUs
+static uint64_t rtcBaseUs = 0;
+static bool rtcRunning = true;
+static bool rtcWriteProtected = false;
+static bool rtcTimeLost = false; // Registers hold no valid date until the next SetDateTime()
+
+static const uint8_t daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+static uint32_t rtcSeconds()
+{
+    return rtcBaseSeconds + (rtcRunning ? (uint32_t)((sim::nowUs() - rtcBaseUs) / 1000000) : 0);
+}
+
+RtcDateTime::RtcDateTime(uint32_t secondsFrom2000)
+{
+    second_ = secondsFrom2000 % 60;
+    uint32_t time = secondsFrom2000 / 60;
+    minute_ = time % 60;
+    time /= 60;
+    hour_ = time % 24;
+    uint16_t days = time / 24;
+
+    bool leap;
+    for (yearFrom2000_ = 0;; yearFrom2000_++)
+    {
+        leap = yearFrom2000_ % 4 == 0;
+        if (days < 365 + leap)
+        {
+            break;
+        }
+        days -= 365 + leap;
+    }
+    for (month_ = 1;; month_++)
+    {
+        uint8_t monthDays = daysInMonth[month_ - 1] + (leap && month_ == 2);
+        if (days < monthDays)
+        {
+            break;
+        }
+        days -= monthDays;
+    }
+    dayOfMonth_ = days + 1;
+}
+
+RtcDateTime::RtcDateTime(uint16_t year, uint8_t month, uint8_t dayOfMonth, uint8_t hour, uint8_t minute, uint8_t second)
+    : yearFrom2000_(year >= 2000 ? year - 2000 : year), month_(month), dayOfMonth_(dayOfMonth), hour_(hour),
+      minute_(minute), second_(second)
+{
+}
+
+// Parses the compiler's __DATE__ ("Mmm dd yyyy") and __TIME__ ("hh:mm:ss")
+RtcDateTime::RtcDateTime(const char *date, const char *time)
+{
+    static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    for (month_ = 1; month_ <= 12; month_++)
+    {
+        if (strncmp(date, months + (month_ - 1) * 3, 3) == 0)
+        {
+            break;
+        }
+    }
+    dayOfMonth_ = atoi(date + 4);
+    yearFrom2000_ = atoi(date + 7) - 2000;
+    hour_ = atoi(time);
+    minute_ = atoi(time + 3);
+    second_ = atoi(time + 6);
+}
+
+bool RtcDateTime::IsValid() const
+{
+    if (month_ < 1 || month_ > 12 || dayOfMonth_ < 1 || hour_ > 23 || minute_ > 59 || second_ > 59)
+    {
+        return false;
+    }
+    return dayOfMonth_ <= daysInMonth[month_ - 1] + (month_ == 2 && yearFrom2000_ % 4 == 0);
+}
+
+uint16_t RtcDateTime::totalDays() const
+{
+    uint16_t days = dayOfMonth_ - 1;
+    for (uint8_t month = 1; month < month_; month++)
+    {
+        days += daysInMonth[month - 1];
+    }
+    if (month_ > 2 && yearFrom2000_ % 4 == 0)
+    {
+        days++;
+    }
+    return days + 365 * yearFrom2000_ + (yearFrom2000_ + 3) / 4;
+}
+
+uint8_t RtcDateTime::DayOfWeek() const
+{
+    return (totalDays() + 6) % 7; // 2000-01-01 was a Saturday
+}
+
+uint32_t RtcDateTime::TotalSeconds() const
+{
+    return ((totalDays() * 24UL + hour_) * 60 + minute_) * 60 + second_;
+}
+
+void SimRtcDS1302::Begin() {}
+
+bool SimRtcDS1302::GetIsWriteProtected()
+{
+    sim::advanceUs(DS1302_REGISTER_US);
+    return rtcWriteProtected;
+}
+
+void SimRtcDS1302::SetIsWriteProtected(bool isWriteProtected)
+{
+    sim::advanceUs(DS1302_REGISTER_US);
+    rtcWriteProtected = isWriteProtected;
+}
+
+bool SimRtcDS1302::GetIsRunning()
+{
+    sim::advanceUs(DS1302_REGISTER_US);
+    return rtcRunning;
+}
+
+void SimRtcDS1302::SetIsRunning(bool isRunning)
+{
+    sim::advanceUs(DS1302_REGISTER_US);
+    rtcBaseSeconds = rtcSeconds();
+    rtcBaseUs = sim::nowUs();
+    rtcRunning = isRunning;
+}
+
+void SimRtcDS1302::SetDateTime(const RtcDateTime &dt)
+{
+    sim::advanceUs(DS1302_BURST_US);
+    if (!rtcWriteProtected)
+    {
+        rtcBaseSeconds = dt.TotalSeconds();
+        rtcBaseUs = sim::nowUs();
+        rtcTimeLost = false;
+    }
+}
+
+RtcDateTime SimRtcDS1302::GetDateTime()
+{
+    sim::advanceUs(DS1302_BURST_US);
+    if (rtcTimeLost)
+    {
+        return RtcDateTime(0, 0, 0, 0, 0, 0); // Month and day 0, which IsValid() rejects
+    }
+    return RtcDateTime(rtcSeconds());
+}
+
+// --- DHT ---
+
+#define DHT_MIN_INTERVAL_MS 2000
+#define DHT_TRANSFER_US 4500 // Sensor response and the 40 data bits
+
+static float climateTemperature = 22.0f;
+static float climateHumidity = 45.0f;
+static bool dhtFailing = false;
+
+void DHT::begin(uint8_t usec)
+{
+    (void)usec;
+    lastReadMs_ = millis() - DHT_MIN_INTERVAL_MS; // Let the first read through
+}
+
+bool DHT::read(bool force)
+{
+    unsigned long now = millis();
+    if (!force && now - lastReadMs_ < DHT_MIN_INTERVAL_MS)
+    {
+        return lastResult_;
+    }
+    lastReadMs_ = now;
+
+    // Let the pull-up settle, hold the start signal low, then clock in the answer
+    delay(1);
+    if (type_ == DHT11)
+    {
+        delay(20);
+    }
+    else
+    {
+        delayMicroseconds(1100);
+    }
+    delayMicroseconds(DHT_TRANSFER_US);
+
+    lastResult_ = !dhtFailing;
+    if (lastResult_)
+    {
+        // The DHT11 reports whole degrees and percent, the DHT22 tenths
+        float scale = type_ == DHT11 ? 1.0f : 10.0f;
+        temperature_ = roundf(climateTemperature * scale) / scale;
+        humidity_ = roundf(climateHumidity * scale) / scale;
+    }
+    return lastResult_;
+}
+
+float DHT::readTemperature(bool fahrenheit, bool force)
+{
+    if (!read(force))
+    {
+        return NAN;
+    }
+    return fahrenheit ? temperature_ * 1.8f + 32 : temperature_;
+}
+
+float DHT::readHumidity(bool force) { return read(force) ? humidity_ : NAN; }
+
+// --- Harness access ---
+
+namespace sim
+{
+void presentCard(uint8_t chipSelectPin, const uint8_t *uid, uint8_t size, uint32_t holdMs)
+{
+    antenna &field = antennas[chipSelectPin];
+    field.present = true;
+    field.removeAtUs = nowUs() + (uint64_t)holdMs * 1000;
+    field.size = size <= sizeof(field.uid) ? size : sizeof(field.uid);
+    memcpy(field.uid, uid, field.size);
+    field.state = CARD_IDLE;
+}
+
+void removeCard(uint8_t chipSelectPin) { antennas[chipSelectPin].present = false; }
+
+ReaderStats readerStats(uint8_t chipSelectPin) { return antennas[chipSelectPin].stats; }
+
+void setRtcTime(uint32_t secondsFrom2000)
+{
+    rtcBaseSeconds = secondsFrom2000;
+    rtcBaseUs = nowUs();
+    rtcTimeLost = false;
+}
+
+void setRtcTimeLost() { rtcTimeLost = true; }
+
+void setClimate(float temperature, float humidity)
+{
+    climateTemperature = temperature;
+    climateHumidity = humidity;
+}
+
+void setDhtFailing(bool failing) { dhtFailing = failing; }
+} // namespace sim
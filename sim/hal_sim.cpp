@@ -0,0 +1,143 @@
+// Host implementation of the platform services declared in src/hal.hpp
+#include <hal.hpp>
+#include <sim.hpp>
+
+#include <string>
+#include <vector>
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/random.h>
+
+// --- Flash file store ---
+// Device paths are rooted at "/" on LittleFS; on the host they are resolved inside the
+// directory chosen with sim::setStoreDir().
+
+static std::string hostPath(const char *path)
+{
+    std::string result = sim::storeDir();
+    if (path[0] != '/')
+    {
+        result += '/';
+    }
+    return result + path;
+}
+
+bool halFsMount() { return true; }
+halFile halFileOpen(const char *path, const char *mode) { return fopen(hostPath(path).c_str(), mode); }
+bool halFileIsOpen(halFile &file) { return file != NULL; }
+bool halFileSeek(halFile &file, uint32_t offset) { return fseek(file, offset, SEEK_SET) == 0; }
+size_t halFileRead(halFile &file, void *data, size_t size) { return fread(data, 1, size, file); }
+size_t halFileWrite(halFile &file, const void *data, size_t size) { return fwrite(data, 1, size, file); }
+void halFileClose(halFile &file) { fclose(file); }
+bool halFileReplace(const char *from, const char *to) { return rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0; }
+
+// --- Background services ---
+
+#define HAL_SERVICE_YIELD_US 1000 // The device's vTaskDelay(1) between steps
+
+void halStartService(const char *name, void (*step)(), uint8_t core)
+{
+    (void)core;
+    sim::startService(name, [step]() {
+        step();
+        sim::advanceUs(HAL_SERVICE_YIELD_US);
+    });
+}
+
+// --- Cycle counter ---
+
+uint32_t halCycleCount() { return (uint32_t)(sim::nowUs() * HAL_CYCLES_PER_US); }
+
+// --- Monotonic time ---
+
+uint64_t halMonotonicUs() { return sim::nowUs(); }
+
+// --- Random numbers ---
+
+void halRandom(void *data, size_t size)
+{
+    uint8_t *bytes = (uint8_t *)data;
+    while (size > 0)
+    {
+        ssize_t got = getrandom(bytes, size, 0);
+        if (got > 0)
+        {
+            bytes += got;
+            size -= got;
+        }
+    }
+}
+
+// --- Heap ---
+
+// glibc reports each free-list bin as <size from= to= total= count=/>, `to` being the
+// biggest chunk in it; the top chunk is not in any bin and comes from mallinfo2().
+static size_t largestFreeChunk(size_t topChunk)
+{
+    char *report = NULL;
+    size_t reportSize = 0;
+    FILE *out = open_memstream(&report, &reportSize);
+    if (out == NULL)
+    {
+        return topChunk;
+    }
+    malloc_info(0, out);
+    fclose(out);
+
+    size_t largest = topChunk;
+    const char *entry = report;
+    while ((entry = strstr(entry, " from=\"")) != NULL)
+    {
+        unsigned long from, to, total, count;
+        if (sscanf(entry, " from=\"%lu\" to=\"%lu\" total=\"%lu\" count=\"%lu\"", &from, &to, &total,
+                   &count) == 4 &&
+            count > 0 && to > largest)
+        {
+            largest = to;
+        }
+        entry++;
+    }
+    free(report);
+    return largest;
+}
+
+halHeapStats halHeap()
+{
+    struct mallinfo2 info = mallinfo2();
+    return {(uint32_t)info.fordblks, (uint32_t)largestFreeChunk(info.keepcost)};
+}
+
+// --- One-shot timers ---
+// Each shot is a scheduled action carrying the timer's arm count, so re-arming or
+// cancelling simply leaves the stale action with nothing to do.
+
+struct simTimer
+{
+    void (*callback)();
+    uint64_t armCount;
+};
+
+static std::vector<simTimer> timers;
+
+halTimer halTimerCreate(const char *name, void (*callback)())
+{
+    (void)name;
+    timers.push_back({callback, 0});
+    return (halTimer)timers.size() - 1;
+}
+
+void halTimerArm(halTimer timer, uint32_t delayUs)
+{
+    uint64_t armCount = ++timers[timer].armCount;
+    sim::schedule(sim::nowUs() + delayUs, [timer, armCount]() {
+        if (timers[timer].armCount == armCount)
+        {
+            timers[timer].callback();
+        }
+    });
+}
+
+void halTimerCancel(halTimer timer) { timers[timer].armCount++; }
@@ -0,0 +1,6 @@
+#ifndef SIM_ADAFRUIT_SENSOR_H
+#define SIM_ADAFRUIT_SENSOR_H
+
+#include <Arduino.h>
+
+#endif // SIM_ADAFRUIT_SENSOR_H
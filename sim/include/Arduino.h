@@ -0,0 +1,228 @@
+// Host stand-in for the subset of the Arduino-ESP32 core used by the firmware.
+// Time is virtual: millis()/micros() read the simulator clock and delay()
+// advances it, so blocking code costs simulated time rather than wall time.
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define HEX 16
+#define DEC 10
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (s)
+#define snprintf_P snprintf
+
+using std::isnan;
+using std::max;
+using std::min;
+
+// --- Virtual clock ---
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// --- GPIO / ADC / PWM ---
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+uint32_t ledcSetup(uint8_t channel, uint32_t freq, uint8_t resolution);
+void ledcAttachPin(uint8_t pin, uint8_t channel);
+void ledcWrite(uint8_t channel, uint32_t duty);
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration = 0);
+void noTone(uint8_t pin);
+
+// --- String ---
+// Arduino's String keeps its text on the heap, so every non-empty String built and every
+// append is a heap allocation on the device; allocations() counts them so the simulator
+// can check the firmware stays off the heap.
+class String
+{
+public:
+    String(const char *cstr = "") : s_(cstr ? cstr : "") { allocated(); }
+    String(const std::string &str) : s_(str) { allocated(); }
+    String(const String &other) : s_(other.s_) { allocated(); }
+    explicit String(char c) : s_(1, c) { allocated(); }
+    String(int value, unsigned char base = DEC) : s_(toBase(value, base)) { allocated(); }
+    String(unsigned int value, unsigned char base = DEC) : s_(toBase(value, base)) { allocated(); }
+    String(long value, unsigned char base = DEC) : s_(toBase(value, base)) { allocated(); }
+    String(unsigned long value, unsigned char base = DEC) : s_(toBase(value, base)) { allocated(); }
+    explicit String(unsigned char value, unsigned char base = DEC) : s_(toBase(value, base)) { allocated(); }
+    explicit String(float value, unsigned char decimals = 2);
+    explicit String(double value, unsigned char decimals = 2);
+
+    String &operator=(const String &other)
+    {
+        s_ = other.s_;
+        allocated();
+        return *this;
+    }
+
+    static unsigned long allocations() { return allocations_; }
+
+    const char *c_str() const { return s_.c_str(); }
+    unsigned int length() const { return (unsigned int)s_.size(); }
+    char charAt(unsigned int index) const { return index < s_.size() ? s_[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+
+    String &operator+=(const String &rhs)
+    {
+        s_ += rhs.s_;
+        allocated();
+        return *this;
+    }
+    String &operator+=(const char *rhs)
+    {
+        s_ += rhs;
+        allocated();
+        return *this;
+    }
+    String &operator+=(char rhs)
+    {
+        s_ += rhs;
+        allocated();
+        return *this;
+    }
+    bool concat(const String &rhs)
+    {
+        s_ += rhs.s_;
+        allocated();
+        return true;
+    }
+
+    friend String operator+(const String &lhs, const String &rhs) { return String(lhs.s_ + rhs.s_); }
+    friend String operator+(const String &lhs, const char *rhs) { return String(lhs.s_ + rhs); }
+    friend String operator+(const char *lhs, const String &rhs) { return String(lhs + rhs.s_); }
+
+    bool operator==(const String &rhs) const { return s_ == rhs.s_; }
+    bool operator==(const char *rhs) const { return s_ == rhs; }
+    bool operator!=(const String &rhs) const { return s_ != rhs.s_; }
+    bool operator!=(const char *rhs) const { return s_ != rhs; }
+
+    void toUpperCase();
+    void toLowerCase();
+    void trim();
+    String substring(unsigned int from) const { return substring(from, length()); }
+    String substring(unsigned int from, unsigned int to) const;
+    int indexOf(char c, unsigned int from = 0) const;
+    long toInt() const { return strtol(s_.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(s_.c_str(), nullptr); }
+    bool startsWith(const String &prefix) const { return s_.compare(0, prefix.s_.size(), prefix.s_) == 0; }
+
+private:
+    static std::string toBase(unsigned long value, unsigned char base);
+    static std::string toBase(long value, unsigned char base);
+    static std::string toBase(int value, unsigned char base) { return toBase((long)value, base); }
+    static std::string toBase(unsigned int value, unsigned char base) { return toBase((unsigned long)value, base); }
+    static std::string toBase(unsigned char value, unsigned char base) { return toBase((unsigned long)value, base); }
+
+    void allocated()
+    {
+        if (!s_.empty())
+        {
+            allocations_++;
+        }
+    }
+
+    static std::atomic<unsigned long> allocations_;
+    std::string s_;
+};
+
+// --- Print / Stream ---
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *str) { return str ? write((const uint8_t *)str, strlen(str)) : 0; }
+    size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+
+    size_t print(const char *str) { return write(str); }
+    size_t print(const String &str) { return write(str.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(int value, int base = DEC) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T &value)
+    {
+        size_t n = print(value);
+        return n + println();
+    }
+    template <typename T>
+    size_t println(const T &value, int format)
+    {
+        size_t n = print(value, format);
+        return n + println();
+    }
+
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual void flush() {}
+};
+
+// Serial port model. Output goes to stdout, to a capture file chosen by the harness, or
+// nowhere (but still counted); input is fed by the harness through inject().
+#define SIM_SERIAL_TX_FIFO 128 // TX room reported to the sketch, the ESP32 UART FIFO size
+
+class HardwareSerial : public Stream
+{
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+    int availableForWrite() { return SIM_SERIAL_TX_FIFO; } // Output is never held back
+    operator bool() const { return true; }
+
+    void inject(const char *data, size_t size);
+    void setOutput(FILE *output) { output_ = output; }
+    unsigned long bytesWritten() const { return bytesWritten_; }
+
+private:
+    std::string rx_;
+    size_t rxPos_ = 0;
+    FILE *output_ = stdout;
+    unsigned long bytesWritten_ = 0;
+};
+
+extern HardwareSerial Serial;
+
+#endif // SIM_ARDUINO_H
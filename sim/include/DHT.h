@@ -0,0 +1,31 @@
+#ifndef SIM_DHT_H
+#define SIM_DHT_H
+
+#include <Arduino.h>
+
+#define DHT11 11
+#define DHT22 22
+
+// DHT model with the Adafruit library's behaviour: a read blocks for the start signal
+// and the 40 bit transfer, and reads closer together than two seconds return the
+// previous result without touching the sensor.
+class DHT
+{
+public:
+    DHT(uint8_t pin, uint8_t type, uint8_t count = 6) : pin_(pin), type_(type) { (void)count; }
+    void begin(uint8_t usec = 55);
+    float readTemperature(bool fahrenheit = false, bool force = false);
+    float readHumidity(bool force = false);
+
+private:
+    bool read(bool force);
+
+    uint8_t pin_;
+    uint8_t type_;
+    unsigned long lastReadMs_ = 0;
+    bool lastResult_ = false;
+    float temperature_ = NAN;
+    float humidity_ = NAN;
+};
+
+#endif // SIM_DHT_H
@@ -0,0 +1,37 @@
+#ifndef SIM_LIQUIDCRYSTAL_I2C_H
+#define SIM_LIQUIDCRYSTAL_I2C_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+// Host build of the LiquidCrystal_I2C driver. It drives the HD44780 through the PCF8574
+// exactly like the real library, one I2C transaction per expander write, so the
+// simulated display and the bus counters see the same traffic as the hardware.
+class LiquidCrystal_I2C : public Print
+{
+public:
+    LiquidCrystal_I2C(uint8_t addr, uint8_t cols, uint8_t rows);
+    void init();
+    void begin(uint8_t cols, uint8_t rows);
+    void backlight();
+    void noBacklight();
+    void clear();
+    void home();
+    void setCursor(uint8_t col, uint8_t row);
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+private:
+    void command(uint8_t value);
+    void send(uint8_t value, uint8_t mode);
+    void write4bits(uint8_t value);
+    void expanderWrite(uint8_t data);
+    void pulseEnable(uint8_t data);
+
+    uint8_t addr_;
+    uint8_t cols_;
+    uint8_t rows_;
+    uint8_t backlightVal_;
+};
+
+#endif // SIM_LIQUIDCRYSTAL_I2C_H
@@ -0,0 +1,51 @@
+#ifndef SIM_MFRC522_H
+#define SIM_MFRC522_H
+
+#include <Arduino.h>
+
+// MFRC522 model. Each instance is bound to the simulated antenna on its chip-select pin,
+// where the harness places cards (sim::presentCard). Cards follow the ISO 14443-3 state
+// machine, so a card left on the antenna answers every other REQA unless it is halted,
+// and every command without an answer costs the library's 25 ms receive timeout.
+class MFRC522
+{
+public:
+    static constexpr byte UNUSED_PIN = UINT8_MAX;
+
+    enum StatusCode : byte
+    {
+        STATUS_OK,
+        STATUS_ERROR,
+        STATUS_COLLISION,
+        STATUS_TIMEOUT,
+        STATUS_NO_ROOM,
+        STATUS_INTERNAL_ERROR,
+        STATUS_INVALID,
+        STATUS_CRC_WRONG,
+        STATUS_MIFARE_NACK = 0xff
+    };
+
+    typedef struct
+    {
+        byte size;
+        byte uidByte[10];
+        byte sak;
+    } Uid;
+
+    Uid uid;
+
+    MFRC522();
+    MFRC522(byte chipSelectPin, byte resetPowerDownPin);
+    void PCD_Init();
+    void PCD_Init(byte chipSelectPin, byte resetPowerDownPin);
+    bool PICC_IsNewCardPresent();
+    bool PICC_ReadCardSerial();
+    StatusCode PICC_HaltA();
+    void PCD_StopCrypto1();
+
+private:
+    byte chipSelectPin_;
+    byte resetPowerDownPin_;
+};
+
+#endif // SIM_MFRC522_H
@@ -0,0 +1,67 @@
+#ifndef SIM_RTCDS1302_H
+#define SIM_RTCDS1302_H
+
+#include <Arduino.h>
+#include <ThreeWire.h>
+
+#ifndef countof
+#define countof(a) (sizeof(a) / sizeof(a[0]))
+#endif
+
+// Seconds between 1970-01-01 and 2000-01-01, the RtcDateTime epoch.
+#define c_UnixEpoch32 946684800
+
+class RtcDateTime
+{
+public:
+    RtcDateTime(uint32_t secondsFrom2000 = 0);
+    RtcDateTime(uint16_t year, uint8_t month, uint8_t dayOfMonth, uint8_t hour, uint8_t minute, uint8_t second);
+    RtcDateTime(const char *date, const char *time);
+
+    bool IsValid() const;
+    uint16_t Year() const { return yearFrom2000_ + 2000; }
+    uint8_t Month() const { return month_; }
+    uint8_t Day() const { return dayOfMonth_; }
+    uint8_t Hour() const { return hour_; }
+    uint8_t Minute() const { return minute_; }
+    uint8_t Second() const { return second_; }
+    uint8_t DayOfWeek() const;
+    uint32_t TotalSeconds() const;
+    uint32_t Unix32Time() const { return TotalSeconds() + c_UnixEpoch32; }
+
+private:
+    uint16_t totalDays() const;
+
+    uint8_t yearFrom2000_ = 0;
+    uint8_t month_ = 1;
+    uint8_t dayOfMonth_ = 1;
+    uint8_t hour_ = 0;
+    uint8_t minute_ = 0;
+    uint8_t second_ = 0;
+};
+
+// DS1302 model. Its time runs off the simulator clock from the last SetDateTime() (or
+// sim::setRtcTime()); each access is charged the bit-banged three-wire transfer.
+class SimRtcDS1302
+{
+public:
+    void Begin();
+    bool GetIsWriteProtected();
+    void SetIsWriteProtected(bool isWriteProtected);
+    bool GetIsRunning();
+    void SetIsRunning(bool isRunning);
+    void SetDateTime(const RtcDateTime &dt);
+    RtcDateTime GetDateTime();
+};
+
+template <class T_WIRE_METHOD>
+class RtcDS1302 : public SimRtcDS1302
+{
+public:
+    RtcDS1302(T_WIRE_METHOD &wire) : wire_(wire) {}
+
+private:
+    T_WIRE_METHOD &wire_;
+};
+
+#endif // SIM_RTCDS1302_H
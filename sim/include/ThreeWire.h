@@ -0,0 +1,20 @@
+#ifndef SIM_THREEWIRE_H
+#define SIM_THREEWIRE_H
+
+#include <Arduino.h>
+
+// Bit-banged three-wire bus of the DS1302. The RTC model charges the transfer time
+// itself, so this only has to exist.
+class ThreeWire
+{
+public:
+    ThreeWire(uint8_t ioPin, uint8_t clkPin, uint8_t cePin) : ioPin_(ioPin), clkPin_(clkPin), cePin_(cePin) {}
+    void begin() {}
+
+private:
+    uint8_t ioPin_;
+    uint8_t clkPin_;
+    uint8_t cePin_;
+};
+
+#endif // SIM_THREEWIRE_H
@@ -0,0 +1,30 @@
+#ifndef SIM_WIRE_H
+#define SIM_WIRE_H
+
+#include <Arduino.h>
+
+// I2C master. Transmissions are charged standard-mode (100 kHz) bus time and handed to
+// the device models on the bus; the only device is the LCD's PCF8574 expander.
+class TwoWire
+{
+public:
+    bool begin() { return true; }
+    bool begin(int sda, int scl)
+    {
+        (void)sda;
+        (void)scl;
+        return true;
+    }
+    void beginTransmission(uint8_t address);
+    size_t write(uint8_t value);
+    uint8_t endTransmission(bool sendStop = true);
+
+private:
+    uint8_t address_ = 0;
+    uint8_t buffer_[128];
+    size_t length_ = 0;
+};
+
+extern TwoWire Wire;
+
+#endif // SIM_WIRE_H
@@ -0,0 +1,92 @@
+// Simulator state shared by the device models and the harness.
+//
+// Time is virtual. The firmware only advances it through delay()/delayMicroseconds()
+// and through the bus time charged by the device models, so a simulated minute costs
+// whatever the host needs to run the loop, not a wall-clock minute. CPU time spent in
+// the firmware's own code is not charged.
+#ifndef SIM_HPP
+#define SIM_HPP
+
+#include <stdint.h>
+
+#include <functional>
+
+namespace sim
+{
+// --- Virtual clock ---
+
+// Microseconds since power-on
+uint64_t nowUs();
+
+// Function to move the clock forward, running any scheduled actions that fall due
+void advanceUs(uint64_t us);
+
+// Function to run `action` once the main core's clock reaches `atUs`. Harness scripts use
+// this to present cards or move the joystick while the firmware is blocked in a delay.
+void schedule(uint64_t atUs, std::function<void()> action);
+
+// --- Background tasks ---
+
+// Function to run `step` repeatedly as a background task with its own clock, standing in
+// for a FreeRTOS task. Whenever the main core advances, the tasks first run until they have
+// caught up, pausing at every advanceUs(), so each meets the devices, harness actions and
+// the other cores at its own point in time, and blocking in one does not stall the others
+// or loop().
+void startService(const char *name, std::function<void()> step);
+
+// --- GPIO / ADC / PWM ---
+
+void setPinLevel(uint8_t pin, int level);
+int pinLevel(uint8_t pin); // Digital level, tone frequency or LEDC duty, whichever drives the pin
+void setAnalogLevel(uint8_t pin, int level);
+int analogLevel(uint8_t pin);
+
+// --- MFRC522 readers, one antenna per chip-select pin ---
+
+// Function to hold a card on the antenna of the reader on `chipSelectPin` for `holdMs`
+void presentCard(uint8_t chipSelectPin, const uint8_t *uid, uint8_t size, uint32_t holdMs);
+void removeCard(uint8_t chipSelectPin);
+
+struct ReaderStats
+{
+    unsigned long polls; // PICC_IsNewCardPresent calls
+    unsigned long reads; // Successful PICC_ReadCardSerial calls
+    unsigned long halts; // PICC_HaltA calls
+    uint64_t lastReadUs; // Time of the last successful read
+};
+ReaderStats readerStats(uint8_t chipSelectPin);
+
+// --- HD44780 display behind the PCF8574 on the I2C bus ---
+
+// Function to copy the visible text of `row` (LCD_COLS characters) into `out`
+void lcdLine(uint8_t row, char *out, uint8_t cols);
+
+struct I2cStats
+{
+    unsigned long bytes;        // Bytes on the bus, address bytes included
+    unsigned long transactions; // START..STOP sequences
+};
+I2cStats i2cStats();
+
+// --- DS1302 ---
+
+// Function to set the time the RTC keeps counting from, in seconds since 2000-01-01
+void setRtcTime(uint32_t secondsFrom2000);
+
+// Function to make the RTC lose its time, as when its backup battery has run out: reads
+// return an invalid date until the time is set again
+void setRtcTimeLost();
+
+// --- DHT ---
+
+void setClimate(float temperature, float humidity);
+void setDhtFailing(bool failing);
+
+// --- Flash file store ---
+
+// Function to choose the host directory that stands in for the device's LittleFS root
+void setStoreDir(const char *dir);
+const char *storeDir();
+} // namespace sim
+
+#endif // SIM_HPP
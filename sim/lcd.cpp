@@ -0,0 +1,295 @@
+// I2C bus, PCF8574 expander and HD44780 controller models, plus the host build of the
+// LiquidCrystal_I2C driver that talks to them.
+#include <LiquidCrystal_I2C.h>
+#include <Wire.h>
+#include <sim.hpp>
+
+TwoWire Wire;
+
+// Standard-mode I2C: 9 clocks (8 data bits and the ACK) per byte at 100 kHz, plus the
+// START and STOP conditions around each transaction
+#define I2C_BYTE_US 90
+#define I2C_START_STOP_US 10
+
+// The backpack's expander address and pin wiring: P0 RS, P1 RW, P2 EN, P3 backlight,
+// P4-P7 the HD44780's D4-D7
+#define EXPANDER_ADDRESS 0x27
+#define EXPANDER_RS 0x01
+#define EXPANDER_EN 0x04
+#define EXPANDER_BACKLIGHT 0x08
+
+static const uint8_t rowOffsets[] = {0x00, 0x40, 0x14, 0x54};
+
+// HD44780 fed by the expander. It latches D4-D7 on the falling edge of EN; after power-on
+// it is in 8-bit mode (every nibble is a whole byte with D0-D3 low) until a function
+// set switches it to 4-bit mode, after which bytes arrive as two nibbles.
+class Hd44780
+{
+public:
+    Hd44780() { memset(ddram_, ' ', sizeof(ddram_)); }
+
+    void expanderWrite(uint8_t pins)
+    {
+        if ((lastPins_ & EXPANDER_EN) && !(pins & EXPANDER_EN))
+        {
+            latch(lastPins_);
+        }
+        lastPins_ = pins;
+    }
+
+    void line(uint8_t row, char *out, uint8_t cols) const
+    {
+        uint8_t start = rowOffsets[row & 3];
+        for (uint8_t col = 0; col < cols; col++)
+        {
+            out[col] = ddram_[(start + col) & 0x7F];
+        }
+        out[cols] = '\0';
+    }
+
+private:
+    void latch(uint8_t pins)
+    {
+        uint8_t nibble = pins >> 4;
+        bool isData = pins & EXPANDER_RS;
+        if (!fourBit_)
+        {
+            execute(nibble << 4, isData);
+        }
+        else if (!haveHighNibble_)
+        {
+            highNibble_ = nibble;
+            haveHighNibble_ = true;
+        }
+        else
+        {
+            haveHighNibble_ = false;
+            execute((highNibble_ << 4) | nibble, isData);
+        }
+    }
+
+    void execute(uint8_t value, bool isData)
+    {
+        if (isData)
+        {
+            if (!cgram_)
+            {
+                ddram_[address_] = value;
+            }
+            step();
+        }
+        else if (value & 0x80) // Set DDRAM address
+        {
+            address_ = value & 0x7F;
+            cgram_ = false;
+        }
+        else if (value & 0x40) // Set CGRAM address, custom characters are not modelled
+        {
+            cgram_ = true;
+        }
+        else if (value & 0x20) // Function set
+        {
+            fourBit_ = !(value & 0x10);
+            haveHighNibble_ = false;
+        }
+        else if (value & 0x04) // Entry mode set
+        {
+            increment_ = value & 0x02;
+        }
+        else if (value == 0x02 || value == 0x03) // Return home
+        {
+            address_ = 0;
+        }
+        else if (value == 0x01) // Clear display
+        {
+            memset(ddram_, ' ', sizeof(ddram_));
+            address_ = 0;
+            increment_ = true;
+        }
+    }
+
+    // Function to move the address counter, wrapping between the two 40 character lines
+    void step()
+    {
+        if (increment_)
+        {
+            address_ = address_ == 0x27 ? 0x40 : address_ == 0x67 ? 0x00 : (address_ + 1) & 0x7F;
+        }
+        else
+        {
+            address_ = address_ == 0x40 ? 0x27 : address_ == 0x00 ? 0x67 : (address_ - 1) & 0x7F;
+        }
+    }
+
+    char ddram_[128];
+    uint8_t address_ = 0;
+    uint8_t lastPins_ = 0;
+    uint8_t highNibble_ = 0;
+    bool haveHighNibble_ = false;
+    bool fourBit_ = false;
+    bool increment_ = true;
+    bool cgram_ = false;
+};
+
+static Hd44780 display;
+static sim::I2cStats i2c;
+
+// --- TwoWire ---
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    address_ = address;
+    length_ = 0;
+}
+
+size_t TwoWire::write(uint8_t value)
+{
+    if (length_ >= sizeof(buffer_))
+    {
+        return 0;
+    }
+    buffer_[length_++] = value;
+    return 1;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+    (void)sendStop;
+    i2c.bytes += 1 + length_;
+    i2c.transactions++;
+    sim::advanceUs(I2C_START_STOP_US + (1 + length_) * I2C_BYTE_US);
+
+    if (address_ != EXPANDER_ADDRESS)
+    {
+        return 2; // Address NACK
+    }
+    for (size_t i = 0; i < length_; i++)
+    {
+        display.expanderWrite(buffer_[i]);
+    }
+    length_ = 0;
+    return 0;
+}
+
+// --- LiquidCrystal_I2C, following the real driver command for command ---
+
+#define LCD_CLEARDISPLAY 0x01
+#define LCD_RETURNHOME 0x02
+#define LCD_ENTRYMODESET 0x04
+#define LCD_DISPLAYCONTROL 0x08
+#define LCD_FUNCTIONSET 0x20
+#define LCD_SETDDRAMADDR 0x80
+#define LCD_ENTRYLEFT 0x02
+#define LCD_DISPLAYON 0x04
+#define LCD_2LINE 0x08
+
+LiquidCrystal_I2C::LiquidCrystal_I2C(uint8_t addr, uint8_t cols, uint8_t rows)
+    : addr_(addr), cols_(cols), rows_(rows), backlightVal_(0)
+{
+}
+
+void LiquidCrystal_I2C::init()
+{
+    Wire.begin();
+    begin(cols_, rows_);
+}
+
+void LiquidCrystal_I2C::begin(uint8_t cols, uint8_t rows)
+{
+    cols_ = cols;
+    rows_ = rows;
+
+    // Power-on wait, then the datasheet's software reset into 4-bit mode
+    delay(50);
+    expanderWrite(backlightVal_);
+    delay(1000);
+    write4bits(0x03 << 4);
+    delayMicroseconds(4500);
+    write4bits(0x03 << 4);
+    delayMicroseconds(4500);
+    write4bits(0x03 << 4);
+    delayMicroseconds(150);
+    write4bits(0x02 << 4);
+
+    command(LCD_FUNCTIONSET | (rows > 1 ? LCD_2LINE : 0));
+    command(LCD_DISPLAYCONTROL | LCD_DISPLAYON);
+    clear();
+    command(LCD_ENTRYMODESET | LCD_ENTRYLEFT);
+    home();
+}
+
+void LiquidCrystal_I2C::backlight()
+{
+    backlightVal_ = EXPANDER_BACKLIGHT;
+    expanderWrite(0);
+}
+
+void LiquidCrystal_I2C::noBacklight()
+{
+    backlightVal_ = 0;
+    expanderWrite(0);
+}
+
+void LiquidCrystal_I2C::clear()
+{
+    command(LCD_CLEARDISPLAY);
+    delayMicroseconds(2000);
+}
+
+void LiquidCrystal_I2C::home()
+{
+    command(LCD_RETURNHOME);
+    delayMicroseconds(2000);
+}
+
+void LiquidCrystal_I2C::setCursor(uint8_t col, uint8_t row)
+{
+    if (row >= rows_)
+    {
+        row = rows_ - 1;
+    }
+    command(LCD_SETDDRAMADDR | (col + rowOffsets[row & 3]));
+}
+
+size_t LiquidCrystal_I2C::write(uint8_t c)
+{
+    send(c, EXPANDER_RS);
+    return 1;
+}
+
+void LiquidCrystal_I2C::command(uint8_t value) { send(value, 0); }
+
+void LiquidCrystal_I2C::send(uint8_t value, uint8_t mode)
+{
+    write4bits((value & 0xF0) | mode);
+    write4bits(((value << 4) & 0xF0) | mode);
+}
+
+void LiquidCrystal_I2C::write4bits(uint8_t value)
+{
+    expanderWrite(value);
+    pulseEnable(value);
+}
+
+void LiquidCrystal_I2C::expanderWrite(uint8_t data)
+{
+    Wire.beginTransmission(addr_);
+    Wire.write(data | backlightVal_);
+    Wire.endTransmission();
+}
+
+void LiquidCrystal_I2C::pulseEnable(uint8_t data)
+{
+    expanderWrite(data | EXPANDER_EN);
+    delayMicroseconds(1);
+    expanderWrite(data & ~EXPANDER_EN);
+    delayMicroseconds(50);
+}
+
+// --- Harness access ---
+
+namespace sim
+{
+void lcdLine(uint8_t row, char *out, uint8_t cols) { display.line(row, out, cols); }
+I2cStats i2cStats() { return i2c; }
+} // namespace sim
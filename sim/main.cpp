@@ -0,0 +1,1585 @@
+// Host simulator entry point.
+// Runs the firmware's unchanged setup() and loop() against the simulated devices and a
+// virtual clock (see sim.hpp), either as a scripted walk-through or as benchmarks.
+//
+// Usage:
+//   badge_sim demo [--serial FILE] [--store DIR]
+//       Scripted session: denied card, entries, a card enrolled from the admin menu, an
+//       exit an hour later, the member's session statistics in the admin menu and a few
+//       serial console commands.
+//       Prints every LCD change; serial output goes to stderr, or raw to FILE so the
+//       attendance frames can be fed to attendance_decoder. Fails if an expected screen
+//       was not shown.
+//   badge_sim bench [--members N] [--store DIR]
+//       Idle loop and sustained scan throughput, re-read suppression, a sweep of foreign
+//       cards and per-reader polling rates as readers are added to the SPI bus in
+//       simulated time, member lookup and attendance encryption cost in host time. Ends with the scan pipeline latency histograms and fails if any grant
+//       was over budget.
+//   badge_sim roster [--members N] [--store DIR]
+//       Bulk member import: parse cost of a 10k-member roster in host time, then N
+//       members imported from a flash file and over 115200-baud serial, as CSV and as
+//       a binary image. Fails unless a corrupt serial roster leaves the table as it was
+//       and a valid one changes nothing until it has arrived whole.
+//   badge_sim soak [--members N] [--hours N] [--store DIR]
+//       Long run (2 simulated hours by default) of scans, console commands and admin
+//       menu browsing that reports the heap every hour. Fails if the firmware built a
+//       String or the heap kept growing after the first hour.
+//   badge_sim queue-stress [--items N]
+//       Hammers the reader-to-UI scan queue from two real threads and checks that every
+//       item arrives once, intact and in order. Build with -DBADGE_SIM_TSAN=ON to run it
+//       under ThreadSanitizer.
+//   badge_sim check
+//       Checks the firmware's date arithmetic against known values and the C library:
+//       leap days, the year 2000 century rule and year rollovers across the DS1302's
+//       2000-2099 range. Then loads version 1 and 2 member snapshots written here and
+//       checks every migrated field and the rewritten file, boots from a journal a power
+//       cut left a partial record in, and starts and resyncs the clock from an RTC that
+//       has lost its time. Ends with the GCM known answers through the firmware's AES
+//       backend and the portable one. Fails on any mismatch.
+
+#include <utils.hpp>
+#include <attendance_frame.hpp>
+#include <roster_format.hpp>
+#include <spsc_queue.hpp>
+#include <sim.hpp>
+
+#include <chrono>
+#include <ctime>
+#include <memory>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <malloc.h>
+#include <unistd.h>
+
+// Firmware entry points, defined in src/main.cpp
+void setup();
+void loop();
+
+#define JOYSTICK_CENTER 1900 // ADC reading of the joystick at rest
+#define LOOP_PASS_US 50      // Rough ESP32 cost of a loop() pass that does no device I/O
+
+// --- Running the firmware ---
+
+// Prints the LCD whenever its contents change, and the LED colour and buzzer tone
+// whenever they change. Each screen's first two rows are also kept, trimmed, as
+// "row 0|row 1" so a script can check what was shown.
+class OutputWatcher
+{
+public:
+    void check()
+    {
+        checkLcd();
+        checkFeedback();
+    }
+
+    // Function to check that `expected` screens were shown in that order, others in between.
+    // Each row only has to start with the expected text, as wider displays add to some
+    // lines (the seconds of a time, say). Prints the first one not shown and returns false.
+    bool showed(const char *const *expected, size_t count) const
+    {
+        size_t next = 0;
+        for (const std::string &screen : screens)
+        {
+            if (next < count && screenMatches(screen, expected[next]))
+            {
+                next++;
+            }
+        }
+        if (next < count)
+        {
+            fprintf(stderr, "Demo: expected screen \"%s\" was not shown\n", expected[next]);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    void checkLcd()
+    {
+        char rows[LCD_ROWS][LCD_COLS + 1];
+        for (uint8_t row = 0; row < LCD_ROWS; row++)
+        {
+            sim::lcdLine(row, rows[row], LCD_COLS);
+        }
+        if (memcmp(rows, shown, sizeof(rows)) == 0)
+        {
+            return;
+        }
+        memcpy(shown, rows, sizeof(rows));
+        printf("[%10.3f s]", sim::nowUs() / 1e6);
+        for (uint8_t row = 0; row < LCD_ROWS; row++)
+        {
+            printf(" |%s|", rows[row]);
+        }
+        printf("\n");
+        screens.push_back(trimmed(rows[0]) + "|" + trimmed(rows[1]));
+    }
+
+    static bool screenMatches(const std::string &screen, const std::string &expected)
+    {
+        size_t shownBar = screen.find('|');
+        size_t expectedBar = expected.find('|');
+        return screen.compare(0, expectedBar, expected, 0, expectedBar) == 0 && expectedBar <= shownBar &&
+               screen.compare(shownBar + 1, expected.size() - expectedBar - 1, expected, expectedBar + 1) == 0;
+    }
+
+    static std::string trimmed(const char *row)
+    {
+        std::string text = row;
+        size_t first = text.find_first_not_of(' ');
+        return first == std::string::npos ? "" : text.substr(first, text.find_last_not_of(' ') - first + 1);
+    }
+
+    void checkFeedback()
+    {
+        // The buzzer pin reads back as the tone frequency while a tone plays and as the
+        // idle HIGH level otherwise
+        int buzzer = sim::pinLevel(BUZZER_PIN);
+        int levels[4] = {sim::pinLevel(RED_PIN), sim::pinLevel(GREEN_PIN), sim::pinLevel(BLUE_PIN),
+                         buzzer > HIGH ? buzzer : 0};
+        if (memcmp(levels, feedback, sizeof(levels)) == 0)
+        {
+            return;
+        }
+        memcpy(feedback, levels, sizeof(levels));
+        printf("[%10.3f s]   LED %3d,%3d,%3d  buzzer %4d Hz\n", sim::nowUs() / 1e6, levels[0], levels[1], levels[2],
+               levels[3]);
+    }
+
+    char shown[LCD_ROWS][LCD_COLS + 1] = {};
+    int feedback[4] = {};
+    std::vector<std::string> screens;
+};
+
+static unsigned long loopCount = 0;
+
+// Function to run loop() until `us` of simulated time have passed
+static void runFor(uint64_t us, OutputWatcher *watcher = nullptr, std::function<void()> afterLoop = nullptr)
+{
+    uint64_t end = sim::nowUs() + us;
+    while (sim::nowUs() < end)
+    {
+        uint64_t before = sim::nowUs();
+        loop();
+        loopCount++;
+        if (sim::nowUs() == before)
+        {
+            sim::advanceUs(LOOP_PASS_US); // CPU time is not modelled, so charge a typical pass
+        }
+        if (watcher)
+        {
+            watcher->check();
+        }
+        if (afterLoop)
+        {
+            afterLoop();
+        }
+    }
+}
+
+static uint64_t secondsUs(double seconds) { return (uint64_t)(seconds * 1e6); }
+
+static void presentAt(double atSeconds, const CardUid &uid, uint32_t holdMs, uint8_t readerPin = SS_PIN)
+{
+    CardUid card = uid;
+    sim::schedule(secondsUs(atSeconds),
+                  [card, holdMs, readerPin]() { sim::presentCard(readerPin, card.bytes, card.size, holdMs); });
+}
+
+// Function to return the reader a member walks up to: the exit reader when inside
+static uint8_t readerFor(const CardUid &uid)
+{
+    int index = uidToIndex(uid);
+    return index >= 0 && memberLogged(index) ? EXIT_SS_PIN : SS_PIN;
+}
+
+// Function to have a member badge in or out, whichever is due when the time comes
+static void badgeAt(double atSeconds, const CardUid &uid, uint32_t holdMs)
+{
+    CardUid card = uid;
+    sim::schedule(secondsUs(atSeconds),
+                  [card, holdMs]() { sim::presentCard(readerFor(card), card.bytes, card.size, holdMs); });
+}
+
+// Function to add up the simulated readers' counters over the configured readers
+static sim::ReaderStats allReaders()
+{
+    sim::ReaderStats total = {};
+    for (int i = 0; i < readerCount; i++)
+    {
+        sim::ReaderStats stats = sim::readerStats(readerConfigs[i].chipSelectPin);
+        total.polls += stats.polls;
+        total.reads += stats.reads;
+        total.halts += stats.halts;
+        total.lastReadUs = std::max(total.lastReadUs, stats.lastReadUs);
+    }
+    return total;
+}
+
+static void joystickAt(double atSeconds, int x, int y)
+{
+    sim::schedule(secondsUs(atSeconds), [x, y]() {
+        sim::setAnalogLevel(JOYSTICK_URY_PIN, x);
+        sim::setAnalogLevel(JOYSTICK_URX_PIN, y);
+    });
+}
+
+// Function to type a command line into the serial console
+static void consoleAt(double atSeconds, const std::string &command)
+{
+    sim::schedule(secondsUs(atSeconds), [command]() {
+        std::string line = command + "\n";
+        Serial.inject(line.data(), line.size());
+    });
+}
+
+// Function to start the firmware with an empty flash store in `storeDir`
+static void powerOn(const char *storeDir)
+{
+    sim::setStoreDir(storeDir);
+    sim::setRtcTime(toEpochTime(RtcDateTime(2025, 3, 3, 8, 0, 0)));
+    sim::setClimate(21.5f, 40.0f);
+    sim::setAnalogLevel(JOYSTICK_URX_PIN, JOYSTICK_CENTER);
+    sim::setAnalogLevel(JOYSTICK_URY_PIN, JOYSTICK_CENTER);
+    sim::setPinLevel(JOYSTICK_SW_PIN, HIGH);
+    setup();
+}
+
+// Function to replace the member table with `count` generated members, all with access
+static void enrollMembers(int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        CardUid &uid = memberUids[i];
+        uid.size = 4;
+        uid.bytes[0] = 0xB0;
+        uid.bytes[1] = i >> 16;
+        uid.bytes[2] = i >> 8;
+        uid.bytes[3] = i;
+        snprintf(details_db[i].name, sizeof(details_db[i].name), "Member %d", i);
+        details_db[i].lastLogTime = 0;
+        details_db[i].lastTimeSpent = 0;
+        bitsetAssign(memberAccessBits, i, true);
+        bitsetAssign(memberLoggedBits, i, false);
+    }
+    uidCount = count;
+    buildMemberIndex();
+    initOccupancy();
+    saveMembers();
+}
+
+static std::string makeStoreDir()
+{
+    char dir[] = "/tmp/badge_sim.XXXXXX";
+    if (!mkdtemp(dir))
+    {
+        perror("mkdtemp");
+        exit(1);
+    }
+    return dir;
+}
+
+static void removeStoreDir(const std::string &dir)
+{
+    unlink((dir + "/members.bin").c_str());
+    unlink((dir + "/members.tmp").c_str());
+    unlink((dir + "/members.log").c_str());
+    unlink((dir + ROSTER_SPOOL_PATH).c_str());
+    rmdir(dir.c_str());
+}
+
+// --- Demo ---
+
+// Screens the demo script must produce, in order
+static const char *const demoScreens[] = {
+    "Access Denied|",                   // John has no access
+    "Access Granted|03/03/2025 08:00",  // Jane
+    "Welcome|Mary Johnson",             // Mary cuts off Jane's screens
+    "Admin Access|Granted",
+    "Scan new card...|",
+    "Card Added:|04A1B2C3",
+    "Admin Exited|",
+    "Welcome|",                         // The new member, not yet named
+    "Left at|03/03/2025 09:00",         // Jane leaves an hour later
+    "Spent time|00h:59m:55s",
+    "From last time|100.00% increase",
+    "Jane Smith|--page 2--",
+    "UID: E3E40B2F|",
+    "Avg: 0h59m|1 sessions",
+    "Month: 1 visits|0h59m",
+    "Week: 1 visits|0h59m",
+    "Admin Exited|",
+    "Members in: 2|",
+};
+
+static int runDemo(const char *serialPath, const char *storeDir)
+{
+    FILE *serialOut = stderr;
+    if (serialPath && !(serialOut = fopen(serialPath, "wb")))
+    {
+        perror(serialPath);
+        return 1;
+    }
+    Serial.setOutput(serialOut);
+
+    std::string dir = storeDir ? storeDir : makeStoreDir();
+    powerOn(dir.c_str());
+
+    OutputWatcher watcher;
+    double t = sim::nowUs() / 1e6;
+    CardUid john = memberUids[0]; // Seed member without access
+    CardUid jane = memberUids[1];
+    CardUid mary = memberUids[2];
+    constexpr CardUid visitor = cardUidFromHex("04A1B2C3");
+
+    presentAt(t + 1, john, 300);
+    presentAt(t + 5, jane, 300);
+    presentAt(t + 5.4, mary, 300); // Cuts off Jane's melody and screens
+    presentAt(t + 20, adminUid, 300);
+    joystickAt(t + 24, 4095, JOYSTICK_CENTER); // Right: next menu page
+    joystickAt(t + 24.3, JOYSTICK_CENTER, JOYSTICK_CENTER);
+    joystickAt(t + 26, JOYSTICK_CENTER, 0); // Down: add access
+    joystickAt(t + 26.2, JOYSTICK_CENTER, JOYSTICK_CENTER);
+    presentAt(t + 28, visitor, 300);
+    presentAt(t + 32, adminUid, 300);
+    presentAt(t + 36, visitor, 300); // The new member badges in
+    presentAt(t + 3600, jane, 300, EXIT_SS_PIN); // Leaves through the exit reader
+
+    // Admin opens Jane's details and steps back through her session statistics pages
+    presentAt(t + 3610, adminUid, 300);
+    joystickAt(t + 3614, 0, JOYSTICK_CENTER); // Left: back to the first menu page
+    joystickAt(t + 3614.2, JOYSTICK_CENTER, JOYSTICK_CENTER);
+    joystickAt(t + 3616, JOYSTICK_CENTER, 0); // Down: see members
+    joystickAt(t + 3616.2, JOYSTICK_CENTER, JOYSTICK_CENTER);
+    joystickAt(t + 3618, 4095, JOYSTICK_CENTER); // Right: Jane
+    joystickAt(t + 3618.2, JOYSTICK_CENTER, JOYSTICK_CENTER);
+    joystickAt(t + 3620, JOYSTICK_CENTER, 0); // Down: her details
+    joystickAt(t + 3620.2, JOYSTICK_CENTER, JOYSTICK_CENTER);
+    for (int page = 0; page < 4; page++)
+    {
+        joystickAt(t + 3622 + 2 * page, 0, JOYSTICK_CENTER); // Left: previous detail page
+        joystickAt(t + 3622.2 + 2 * page, JOYSTICK_CENTER, JOYSTICK_CENTER);
+    }
+    presentAt(t + 3632, adminUid, 300);
+
+    // An operator checks in over the serial console and names the visitor
+    char janeHex[UID_HEX_SIZE];
+    consoleAt(t + 3640, "present");
+    consoleAt(t + 3641, std::string("member ") + formatCardUid(jane, janeHex));
+    consoleAt(t + 3642, "grant 04A1B2C3 Visiting Vera");
+    consoleAt(t + 3643, "members");
+    consoleAt(t + 3644, "stats");
+    runFor(secondsUs(3650), &watcher);
+    bool passed = watcher.showed(demoScreens, sizeof(demoScreens) / sizeof(demoScreens[0]));
+
+    flushAttendanceLog(true);
+    if (serialPath)
+    {
+        fclose(serialOut);
+    }
+    if (!storeDir)
+    {
+        removeStoreDir(dir);
+    }
+    return passed ? 0 : 1;
+}
+
+// --- Benchmarks ---
+
+// Host-time cost of member lookups through the hash index, against the linear scan it replaced
+template <int SLOTS>
+static void benchLookup(int members)
+{
+    std::vector<CardUid> uids(members);
+    uint32_t seed = 2463534242u;
+    for (CardUid &uid : uids)
+    {
+        uid.size = (seed & 1) ? 7 : 4;
+        for (uint8_t i = 0; i < uid.size; i++)
+        {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            uid.bytes[i] = seed;
+        }
+    }
+
+    std::unique_ptr<MemberIndex<SLOTS>> index(new MemberIndex<SLOTS>(uids.data()));
+    for (int i = 0; i < members; i++)
+    {
+        index->insert(i);
+    }
+
+    CardUid unknown = cardUidFromHex("DEADBEEF");
+    const int rounds = 2000000;
+    long found = 0;
+    static volatile long sink __attribute__((unused)); // Keeps the lookups from being optimised away
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++)
+    {
+        found += index->find(uids[i % members]) >= 0;
+    }
+    auto hitEnd = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++)
+    {
+        unknown.bytes[3] = i;
+        found += index->find(unknown) >= 0;
+    }
+    auto missEnd = std::chrono::steady_clock::now();
+
+    // The linear scan is O(n), so fewer rounds keep it quick at 10k members
+    int linearRounds = rounds / std::max(1, members / 10);
+    for (int i = 0; i < linearRounds; i++)
+    {
+        const CardUid &wanted = uids[(i * 7919u) % members];
+        for (int m = 0; m < members; m++)
+        {
+            if (uids[m] == wanted)
+            {
+                found++;
+                break;
+            }
+        }
+    }
+    auto linearEnd = std::chrono::steady_clock::now();
+    sink = found;
+
+    typedef std::chrono::duration<double, std::nano> ns;
+    printf("  %6d members: index hit %6.1f ns, index miss %6.1f ns, linear scan %9.1f ns\n", members,
+           ns(hitEnd - start).count() / rounds, ns(missEnd - hitEnd).count() / rounds,
+           ns(linearEnd - missEnd).count() / linearRounds);
+}
+
+struct deviceCounters
+{
+    uint64_t timeUs;
+    unsigned long loops;
+    sim::ReaderStats reader;
+    sim::I2cStats i2c;
+    unsigned long serialBytes;
+
+    static deviceCounters now()
+    {
+        return {sim::nowUs(), loopCount, allReaders(), sim::i2cStats(), Serial.bytesWritten()};
+    }
+};
+
+static void printRates(const deviceCounters &from, const deviceCounters &to)
+{
+    double minutes = (to.timeUs - from.timeUs) / 60e6;
+    double seconds = minutes * 60;
+    printf("  loop passes      %10.1f /s\n", (to.loops - from.loops) / seconds);
+    printf("  reader polls     %10.1f /s\n", (to.reader.polls - from.reader.polls) / seconds);
+    printf("  cards read       %10.1f /min\n", (to.reader.reads - from.reader.reads) / minutes);
+    printf("  LCD I2C          %10.0f bytes/min in %.0f transactions/min\n", (to.i2c.bytes - from.i2c.bytes) / minutes,
+           (to.i2c.transactions - from.i2c.transactions) / minutes);
+    printf("  serial           %10.0f bytes/min\n", (to.serialBytes - from.serialBytes) / minutes);
+}
+
+// A queue of members badging in and out: each holds the card until the reader has read
+// it, takes it away CARD_HOLD_MS later, and the next member presents theirs
+// NEXT_CARD_MS after that. Members cycle through a small pool so entries and exits mix,
+// each at the reader for their direction.
+#define CARD_HOLD_MS 300
+#define NEXT_CARD_MS 700
+#define QUEUE_POOL 50
+#define QUEUE_WAIT_MS 60000 // Longest a member waits before giving up
+
+static void benchScanQueue(int members, double minutes)
+{
+    int pool = std::min(QUEUE_POOL, members);
+    int next = 0;
+    unsigned long seenReads = allReaders().reads;
+    unsigned long droppedBefore = scansDropped;
+    uint64_t presentedAt = 0;
+    uint8_t readerPin = SS_PIN;
+    uint64_t totalWaitUs = 0, maxWaitUs = 0;
+    unsigned long served = 0;
+
+    std::function<void()> presentNext = [&]() {
+        const CardUid &uid = memberUids[next++ % pool];
+        presentedAt = sim::nowUs();
+        readerPin = readerFor(uid);
+        sim::presentCard(readerPin, uid.bytes, uid.size, QUEUE_WAIT_MS);
+    };
+    presentNext();
+
+    deviceCounters from = deviceCounters::now();
+    auto wallStart = std::chrono::steady_clock::now();
+    runFor(secondsUs(minutes * 60), nullptr, [&]() {
+        sim::ReaderStats stats = allReaders();
+        if (stats.reads == seenReads)
+        {
+            return;
+        }
+        // The card was read; the member takes it away and the next one steps up
+        seenReads = stats.reads;
+        uint64_t waitUs = stats.lastReadUs - presentedAt;
+        totalWaitUs += waitUs;
+        maxWaitUs = std::max(maxWaitUs, waitUs);
+        served++;
+        uint64_t removeAt = std::max<uint64_t>(sim::nowUs(), stats.lastReadUs + CARD_HOLD_MS * 1000ULL);
+        uint8_t pin = readerPin;
+        sim::schedule(removeAt, [pin]() { sim::removeCard(pin); });
+        sim::schedule(removeAt + NEXT_CARD_MS * 1000ULL, presentNext);
+    });
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    sim::removeCard(readerPin); // The next member in line walks away
+    runFor(secondsUs(5));
+
+    printf("Scan queue, %d members enrolled, %.0f simulated minutes (%.2f s host time):\n", members, minutes,
+           wallSeconds);
+    printRates(from, deviceCounters::now());
+    printf("  wait at reader   %10.1f ms mean, %.1f ms max over %lu members\n", served ? totalWaitUs / 1000.0 / served : 0.0,
+           maxWaitUs / 1000.0, served);
+    printf("  scans dropped    %10lu (UI more than %d scans behind)\n", scansDropped - droppedBefore, SCAN_QUEUE_SIZE);
+}
+
+// A badge left lying at the edge of the antenna for RESTING_SECONDS: it drops out of the
+// field and comes back every FLUTTER_MS, and each time the reader finds it again
+#define RESTING_SECONDS 10
+#define FLUTTER_MS 500
+
+static void benchRestingBadge()
+{
+    CardUid uid = memberUids[uidCount - 1]; // Not one of the scan queue's members
+    unsigned long readsBefore = sim::readerStats(SS_PIN).reads;
+    unsigned long suppressedBefore = scansSuppressed;
+    int occupancyBefore = occupancyCount;
+
+    uint64_t start = sim::nowUs();
+    for (int ms = 0; ms < RESTING_SECONDS * 1000; ms += FLUTTER_MS)
+    {
+        sim::schedule(start + ms * 1000ULL, [uid]() { sim::presentCard(SS_PIN, uid.bytes, uid.size, FLUTTER_MS - 50); });
+    }
+    runFor(secondsUs(RESTING_SECONDS + 5));
+
+    unsigned long reads = sim::readerStats(SS_PIN).reads - readsBefore;
+    unsigned long suppressed = scansSuppressed - suppressedBefore;
+    printf("Badge resting on the reader for %d s, back in the field every %d ms:\n", RESTING_SECONDS, FLUTTER_MS);
+    printf("  card reads       %10lu\n", reads);
+    printf("  re-reads dropped %10lu (%d ms window)\n", suppressed, REREAD_WINDOW_MS);
+    printf("  scans to the UI  %10lu, occupancy %d -> %d\n", reads - suppressed, occupancyBefore, occupancyCount);
+}
+
+// Someone sweeping a stack of SWEEP_CARDS foreign cards past the reader, one every
+// SWEEP_EVERY_MS, twice over. Measures how much of it reaches the buzzer.
+#define SWEEP_CARDS 40
+#define SWEEP_PASSES 2
+#define SWEEP_EVERY_MS 400
+#define SWEEP_HOLD_MS 150
+
+// Function to time sealing `total` bytes in batches of `batch` bytes through the firmware's
+// AES backend, in host time
+static void benchSealBatches(const char *label, size_t batch, size_t total)
+{
+    std::vector<uint8_t> data(batch);
+    uint8_t nonce[AES_GCM_NONCE_BYTES] = {0};
+    uint8_t tag[AES_GCM_TAG_BYTES];
+    size_t calls = total / batch;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < calls; i++)
+    {
+        memcpy(nonce, &i, sizeof(i));
+        sealRecords(nonce, nullptr, 0, data.data(), batch, tag);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("  %-22s %7.2f MB/s, %8.2f us per call\n", label, calls * batch / seconds / 1e6, seconds * 1e6 / calls);
+}
+
+static void benchCrypto()
+{
+    printf("AES-128-GCM sealing, %s backend (host time):\n", cryptoBackend());
+    benchSealBatches("4 KiB batches", 4096, 8 << 20);
+    benchSealBatches("full attendance frame", ATTENDANCE_FRAME_MAX_EVENTS * ATTENDANCE_EVENT_BYTES, 2 << 20);
+    benchSealBatches("one event per call", ATTENDANCE_EVENT_BYTES, 1 << 20);
+}
+
+static void benchCardSweep()
+{
+    DenialStats before = denialStats;
+    unsigned long readsBefore = sim::readerStats(SS_PIN).reads;
+
+    uint64_t start = sim::nowUs();
+    for (int n = 0; n < SWEEP_CARDS * SWEEP_PASSES; n++)
+    {
+        CardUid card;
+        card.size = 4;
+        card.bytes[0] = 0xF0;
+        card.bytes[1] = 0x0D;
+        card.bytes[2] = 0;
+        card.bytes[3] = n % SWEEP_CARDS;
+        sim::schedule(start + n * SWEEP_EVERY_MS * 1000ULL,
+                      [card]() { sim::presentCard(SS_PIN, card.bytes, card.size, SWEEP_HOLD_MS); });
+    }
+
+    // Time the buzzer spends sounding over the sweep
+    uint64_t buzzerUs = 0;
+    uint64_t lastUs = sim::nowUs();
+    runFor(secondsUs(SWEEP_CARDS * SWEEP_PASSES * SWEEP_EVERY_MS / 1000.0 + 5), nullptr, [&]() {
+        uint64_t now = sim::nowUs();
+        if (sim::pinLevel(BUZZER_PIN) > HIGH)
+        {
+            buzzerUs += now - lastUs;
+        }
+        lastUs = now;
+    });
+
+    double seconds = (sim::nowUs() - start) / 1e6;
+    printf("Sweep of %d foreign cards, %d passes, one every %d ms:\n", SWEEP_CARDS, SWEEP_PASSES, SWEEP_EVERY_MS);
+    printf("  card reads       %10lu\n", sim::readerStats(SS_PIN).reads - readsBefore);
+    printf("  denied           %10lu, %lu from the negative cache\n", denialStats.denied - before.denied,
+           denialStats.cached - before.cached);
+    printf("  rate limited     %10lu (%d shown per %d ms)\n", denialStats.limited - before.limited,
+           DENIED_FEEDBACK_MAX, DENIED_WINDOW_MS);
+    printf("  buzzer sounding  %10.2f s of %.1f s\n", buzzerUs / 1e6, seconds);
+}
+
+// Readers added to the SPI bus one at a time with no card on any of them, measuring how
+// often each one is polled
+#define READERS_IDLE_SECONDS 10
+static const uint8_t benchReaderPins[MAX_READERS] = {SS_PIN, EXIT_SS_PIN, 14, 12};
+
+static void benchReaders()
+{
+    ReaderConfig configured[MAX_READERS];
+    memcpy(configured, readerConfigs, sizeof(configured));
+    int configuredCount = readerCount;
+
+    printf("Readers sharing the SPI bus, %d simulated s idle each:\n", READERS_IDLE_SECONDS);
+    for (int count = 1; count <= MAX_READERS; count++)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            readerConfigs[i] = {benchReaderPins[i], READER_TOGGLE, "bench"};
+        }
+        readerCount = count;
+        startReaders();
+
+        unsigned long before[MAX_READERS];
+        for (int i = 0; i < count; i++)
+        {
+            before[i] = sim::readerStats(benchReaderPins[i]).polls;
+        }
+        runFor(secondsUs(READERS_IDLE_SECONDS));
+
+        double low = 1e9, high = 0;
+        for (int i = 0; i < count; i++)
+        {
+            double rate = (sim::readerStats(benchReaderPins[i]).polls - before[i]) / (double)READERS_IDLE_SECONDS;
+            low = std::min(low, rate);
+            high = std::max(high, rate);
+        }
+        printf("  %d reader%s  %6.1f to %6.1f polls/s per reader, a card waits up to %.0f ms\n", count,
+               count == 1 ? " " : "s", low, high, 1000 / low);
+    }
+
+    memcpy(readerConfigs, configured, sizeof(configured));
+    readerCount = configuredCount;
+    startReaders();
+}
+
+static int runBench(int members, const char *storeDir)
+{
+    Serial.setOutput(nullptr);
+    std::string dir = storeDir ? storeDir : makeStoreDir();
+    powerOn(dir.c_str());
+    enrollMembers(members);
+
+    printf("Member lookup (host time):\n");
+    benchLookup<32>(10);
+    benchLookup<2048>(1000);
+    benchLookup<32768>(10000);
+
+    // Let the startup screens settle before measuring
+    runFor(secondsUs(10));
+    deviceCounters from = deviceCounters::now();
+    runFor(secondsUs(60));
+    printf("Idle, %d members enrolled, 1 simulated minute:\n", members);
+    printRates(from, deviceCounters::now());
+
+    benchScanQueue(members, 10);
+    benchRestingBadge();
+    benchCardSweep();
+    benchReaders();
+    benchCrypto();
+
+    // Ask for the latency histograms the way an operator would, over serial
+    printf("Scan pipeline latency over all benchmarks (simulated time, device I/O only):\n");
+    fflush(stdout);
+    Serial.setOutput(stdout);
+    Serial.inject("latency\n", 8);
+    runFor(secondsUs(0.1));
+    Serial.setOutput(nullptr);
+
+    if (!storeDir)
+    {
+        removeStoreDir(dir);
+    }
+#if LATENCY_PROBES
+    return scansOverBudget > 0 ? 1 : 0; // Enforce the scan-to-grant budget
+#else
+    return 0;
+#endif
+}
+
+// --- Roster import ---
+
+#define SERIAL_BYTES_PER_MS 11.52 // 115200 baud, 10 bits per byte
+#define ROSTER_SERIAL_WAIT_S 7     // Time past the last byte to wait for the import to end
+
+static void generatedRosterMember(int i, RosterRecord &record, bool hasAccess = true)
+{
+    record.uid.size = 4;
+    record.uid.bytes[0] = 0xC0;
+    record.uid.bytes[1] = i >> 16;
+    record.uid.bytes[2] = i >> 8;
+    record.uid.bytes[3] = i;
+    snprintf(record.name, sizeof(record.name), "Member %d", i);
+    record.hasAccess = hasAccess;
+}
+
+static std::string makeRosterCsv(int count)
+{
+    std::string csv = "uid,name,access\n";
+    for (int i = 0; i < count; i++)
+    {
+        RosterRecord record;
+        generatedRosterMember(i, record);
+        char uidHex[UID_HEX_SIZE];
+        csv += formatCardUid(record.uid, uidHex);
+        csv += ',';
+        csv += record.name;
+        csv += ",1\n";
+    }
+    return csv;
+}
+
+static std::string makeRosterImage(int count, bool hasAccess = true)
+{
+    uint8_t buffer[ROSTER_RECORD_MAX_BYTES];
+    size_t length = encodeRosterHeader(count, buffer);
+    std::string image((char *)buffer, length);
+    uint32_t crc = crc32(buffer + 4, length - 4);
+    for (int i = 0; i < count; i++)
+    {
+        RosterRecord record;
+        generatedRosterMember(i, record, hasAccess);
+        length = encodeRosterRecord(record, buffer);
+        image.append((char *)buffer, length);
+        crc = crc32(buffer, length, crc);
+    }
+    length = encodeRosterCrc(crc, buffer);
+    return image.append((char *)buffer, length);
+}
+
+static void countRecord(const RosterRecord &record, void *context)
+{
+    (void)record;
+    (*(unsigned long *)context)++;
+}
+
+// Host-time cost of parsing a roster, with nothing done per member
+static void benchRosterParse(const char *label, const std::string &roster, int count)
+{
+    unsigned long parsed = 0;
+    auto start = std::chrono::steady_clock::now();
+    RosterParser parser(countRecord, &parsed);
+    parser.feed((const uint8_t *)roster.data(), roster.size());
+    bool valid = parser.finish();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("  parse %-6s %6d members, %7zu bytes: %6.1f ms host (%.0f ns/member)%s\n", label, count, roster.size(),
+           seconds * 1e3, seconds * 1e9 / count, valid && parsed == (unsigned long)count ? "" : " INVALID");
+}
+
+// Function to drop `roster` onto the flash and import it the way setup() does
+static void benchRosterFile(const char *label, const std::string &roster)
+{
+    enrollMembers(0);
+    std::string path = std::string(sim::storeDir()) + ROSTER_PATH;
+    FILE *file = fopen(path.c_str(), "wb");
+    fwrite(roster.data(), 1, roster.size(), file);
+    fclose(file);
+
+    auto start = std::chrono::steady_clock::now();
+    bool valid = importRosterFile(ROSTER_PATH);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("  flash  %-6s %d members enrolled in %.1f ms host%s\n", label, uidCount, seconds * 1e3,
+           valid ? "" : " FAILED");
+    unlink((std::string(sim::storeDir()) + ROSTER_DONE_PATH).c_str());
+}
+
+// Function to send `roster` over serial at 115200 baud after the "roster" command and run
+// loop() until the import ends, calling `whileImporting` after each pass until then.
+// Returns how long it took, counting loop() passes meanwhile.
+static uint64_t sendRosterSerial(const std::string &roster, unsigned long &loops,
+                                 std::function<void()> whileImporting = nullptr)
+{
+    std::string data = "roster\n" + roster;
+    uint64_t start = sim::nowUs();
+    size_t sent = 0;
+    for (uint64_t ms = 1; sent < data.size(); ms++)
+    {
+        size_t upTo = std::min(data.size(), (size_t)(ms * SERIAL_BYTES_PER_MS));
+        std::string chunk = data.substr(sent, upTo - sent);
+        sim::schedule(start + ms * 1000, [chunk]() { Serial.inject(chunk.data(), chunk.size()); });
+        sent = upTo;
+    }
+
+    bool started = false;
+    uint64_t finished = 0;
+    unsigned long loopsBefore = loopCount;
+    runFor(secondsUs(data.size() / SERIAL_BYTES_PER_MS / 1000 + ROSTER_SERIAL_WAIT_S), nullptr, [&]() {
+        if (rosterImportActive())
+        {
+            started = true;
+            if (whileImporting)
+            {
+                whileImporting();
+            }
+        }
+        else if (started && !finished)
+        {
+            finished = sim::nowUs();
+            loops = loopCount - loopsBefore;
+        }
+    });
+    return finished - start;
+}
+
+static void benchRosterSerial(const char *label, const std::string &roster)
+{
+    enrollMembers(0);
+    runFor(secondsUs(3)); // Let the feedback from the reset settle
+
+    unsigned long loops = 0;
+    uint64_t us = sendRosterSerial(roster, loops);
+    printf("  serial %-6s %d members enrolled in %.2f s simulated (%zu bytes on the wire), %.0f loop() passes/s meanwhile\n",
+           label, uidCount, us / 1e6, roster.size() + 7, loops / (us / 1e6));
+}
+
+// Function to tell whether every enrolled member has access
+static bool allHaveAccess()
+{
+    for (int i = 0; i < uidCount; i++)
+    {
+        if (!memberHasAccess(i))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A binary roster revoking every member whose CRC does not match: once it fails, the
+// table must be as it was before it started, and it must not have changed while the
+// roster streamed in. Then the same roster intact, which must change nothing until it has
+// arrived whole. Returns false if any of that does not hold.
+static bool benchRosterRollback(int members)
+{
+    std::string image = makeRosterImage(members, false);
+    image.back() ^= 0xFF;
+    std::string extra = makeRosterImage(members + 10, false); // Also appends ten members
+    extra.back() ^= 0xFF;
+
+    bool restored = true;
+    bool untouched = true;
+    for (const std::string &roster : {image, extra})
+    {
+        int countBefore = uidCount;
+        unsigned long loops = 0;
+        sendRosterSerial(roster, loops, [&]() { untouched = untouched && allHaveAccess() && uidCount == countBefore; });
+        restored = restored && allHaveAccess() && uidCount == countBefore;
+    }
+    printf("  corrupt roster   %s\n", restored && untouched ? "rejected, members and access as before"
+                                                           : "CHANGED THE MEMBER TABLE");
+
+    unsigned long loops = 0;
+    std::string revoke = makeRosterImage(members, false);
+    sendRosterSerial(revoke, loops, [&]() { untouched = untouched && allHaveAccess(); });
+    bool applied = uidCount == members;
+    for (int i = 0; i < uidCount; i++)
+    {
+        applied = applied && !memberHasAccess(i);
+    }
+    printf("  revoking roster  %s\n", untouched && applied ? "applied once complete" : "APPLIED WHILE STREAMING");
+    return restored && untouched && applied;
+}
+
+static int runRosterBench(int members, const char *storeDir)
+{
+    Serial.setOutput(nullptr);
+    std::string dir = storeDir ? storeDir : makeStoreDir();
+    powerOn(dir.c_str());
+
+    const int parseMembers = 10000;
+    std::string csv = makeRosterCsv(members);
+    std::string image = makeRosterImage(members);
+
+    printf("Roster import:\n");
+    benchRosterParse("CSV", makeRosterCsv(parseMembers), parseMembers);
+    benchRosterParse("binary", makeRosterImage(parseMembers), parseMembers);
+    benchRosterFile("CSV", csv);
+    benchRosterFile("binary", image);
+    benchRosterSerial("CSV", csv + "end\n");
+    benchRosterSerial("binary", image);
+    bool rolledBack = benchRosterRollback(members);
+
+    if (!storeDir)
+    {
+        unlink((dir + ROSTER_PATH).c_str());
+        removeStoreDir(dir);
+    }
+    return rolledBack ? 0 : 1;
+}
+
+// --- Heap soak ---
+
+#define SOAK_HEAP_SLACK 4096 // Heap growth over the soak still counted as flat, in bytes
+
+static unsigned long soakScans = 0;
+
+// Function to script one simulated minute of traffic, then schedule the next one. Most
+// minutes bring four member scans and a foreign card; every ten minutes an operator runs a
+// few console commands, and twice an hour the admin browses a member's detail pages.
+static void soakMinute(uint64_t startUs, int minute)
+{
+    double t = startUs / 1e6;
+    int members = uidCount;
+    if (minute % 30 == 15)
+    {
+        presentAt(t, adminUid, 300);
+        joystickAt(t + 4, 0, JOYSTICK_CENTER); // Left: first menu page
+        joystickAt(t + 4.2, JOYSTICK_CENTER, JOYSTICK_CENTER);
+        joystickAt(t + 6, JOYSTICK_CENTER, 0); // Down: see members
+        joystickAt(t + 6.2, JOYSTICK_CENTER, JOYSTICK_CENTER);
+        joystickAt(t + 8, 4095, JOYSTICK_CENTER); // Right: next member
+        joystickAt(t + 8.2, JOYSTICK_CENTER, JOYSTICK_CENTER);
+        joystickAt(t + 10, JOYSTICK_CENTER, 0); // Down: details
+        joystickAt(t + 10.2, JOYSTICK_CENTER, JOYSTICK_CENTER);
+        for (int page = 0; page < 8; page++)
+        {
+            joystickAt(t + 12 + 2 * page, 4095, JOYSTICK_CENTER); // Right: next detail page
+            joystickAt(t + 12.2 + 2 * page, JOYSTICK_CENTER, JOYSTICK_CENTER);
+        }
+        presentAt(t + 30, adminUid, 300);
+        soakScans += 2;
+    }
+    else
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            badgeAt(t + 2 + 15 * i, memberUids[((minute * 4 + i) * 7919u) % members], 300);
+        }
+        CardUid foreign = cardUidFromHex("DEAD0000");
+        foreign.bytes[3] = minute % 64;
+        presentAt(t + 9, foreign, 300);
+        soakScans += 5;
+    }
+    if (minute % 10 == 5)
+    {
+        char uidHex[UID_HEX_SIZE];
+        consoleAt(t + 50, "present");
+        consoleAt(t + 52, std::string("member ") + formatCardUid(memberUids[minute % members], uidHex));
+        consoleAt(t + 54, "stats");
+    }
+
+    uint64_t nextUs = startUs + secondsUs(60);
+    sim::schedule(nextUs, [nextUs, minute]() { soakMinute(nextUs, minute + 1); });
+}
+
+// Function to print one row of the soak report
+static void printSoakRow(int hour, unsigned long allocations)
+{
+    struct mallinfo2 info = mallinfo2();
+    halHeapStats heap = halHeap();
+    printf("  %4d %8lu %13lu %11zu %10lu %10lu\n", hour, soakScans, allocations, info.uordblks,
+           (unsigned long)heap.freeBytes, (unsigned long)heap.largestFreeBlock);
+}
+
+static int runSoak(int members, int hours, const char *storeDir)
+{
+    Serial.setOutput(nullptr);
+    std::string dir = storeDir ? storeDir : makeStoreDir();
+    powerOn(dir.c_str());
+    enrollMembers(members);
+    runFor(secondsUs(10)); // Let the startup screens settle
+
+    unsigned long allocationsAtStart = String::allocations();
+    soakMinute(sim::nowUs(), 0);
+
+    printf("Heap soak, %d members, %d simulated hours:\n", members, hours);
+    printf("  hour    scans String allocs   heap used  heap free    largest\n");
+    printSoakRow(0, 0);
+    size_t usedAfterFirstHour = 0;
+    for (int hour = 1; hour <= hours; hour++)
+    {
+        runFor(secondsUs(3600));
+        if (hour == 1)
+        {
+            usedAfterFirstHour = mallinfo2().uordblks;
+        }
+        printSoakRow(hour, String::allocations() - allocationsAtStart);
+    }
+
+    // The first hour grows the simulator's own bookkeeping to its working size; from then
+    // on a firmware that allocates nothing leaves the heap where it was
+    unsigned long allocations = String::allocations() - allocationsAtStart;
+    long growth = (long)mallinfo2().uordblks - (long)usedAfterFirstHour;
+    printf("String allocations by the firmware: %lu, heap growth after the first hour: %ld bytes\n", allocations,
+           growth);
+
+    if (!storeDir)
+    {
+        removeStoreDir(dir);
+    }
+    return allocations == 0 && growth <= SOAK_HEAP_SLACK ? 0 : 1;
+}
+
+// --- Scan queue stress test ---
+
+// Fills every byte of a scan from its sequence number so torn copies are caught
+static void makeStressScan(uint32_t sequence, ScanEvent &scan)
+{
+    scan.uid.size = 4 + sequence % 7;
+    for (uint8_t i = 0; i < UID_MAX_BYTES; i++)
+    {
+        scan.uid.bytes[i] = (uint8_t)(sequence >> (8 * (i % 4))) ^ i;
+    }
+    scan.readAt = sequence;
+}
+
+static int runQueueStress(unsigned long items)
+{
+    static SpscQueue<ScanEvent, SCAN_QUEUE_SIZE> queue;
+    unsigned long producerFull = 0;
+    unsigned long errors = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread producer([&]() {
+        ScanEvent scan;
+        for (unsigned long sequence = 0; sequence < items; sequence++)
+        {
+            makeStressScan(sequence, scan);
+            while (!queue.push(scan))
+            {
+                producerFull++;
+                std::this_thread::yield();
+            }
+        }
+    });
+    std::thread consumer([&]() {
+        ScanEvent scan, expected;
+        for (unsigned long sequence = 0; sequence < items; sequence++)
+        {
+            while (!queue.pop(scan))
+            {
+                std::this_thread::yield();
+            }
+            makeStressScan(sequence, expected);
+            if (scan.readAt != expected.readAt || scan.uid != expected.uid)
+            {
+                errors++;
+            }
+        }
+    });
+    producer.join();
+    consumer.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("Scan queue stress: %lu items in %.2f s (%.2f M items/s), producer found it full %lu times, %lu errors\n",
+           items, seconds, items / seconds / 1e6, producerFull, errors);
+    return errors == 0 && queue.size() == 0 ? 0 : 1;
+}
+
+// --- Firmware checks ---
+
+// One date with its seconds since 2000-01-01, worked out independently of the firmware
+struct KnownEpoch
+{
+    uint16_t year;
+    uint8_t month, day, hour, minute, second;
+    EpochTime expected;
+    const char *text;
+};
+
+static const KnownEpoch knownEpochs[] = {
+    {2000, 1, 1, 0, 0, 0, 0, "01/01/2000 00:00:00"},
+    {2000, 2, 28, 23, 59, 59, 5097599, "02/28/2000 23:59:59"},
+    {2000, 2, 29, 0, 0, 0, 5097600, "02/29/2000 00:00:00"}, // 2000 is a leap year by the 400-year rule
+    {2000, 3, 1, 0, 0, 0, 5184000, "03/01/2000 00:00:00"},
+    {2000, 12, 31, 23, 59, 59, 31622399, "12/31/2000 23:59:59"},
+    {2001, 1, 1, 0, 0, 0, 31622400, "01/01/2001 00:00:00"},
+    {2001, 3, 1, 0, 0, 0, 36720000, "03/01/2001 00:00:00"}, // No February 29th in 2001
+    {2024, 2, 29, 12, 0, 0, 762523200, "02/29/2024 12:00:00"},
+    {2025, 3, 3, 8, 0, 0, 794304000, "03/03/2025 08:00:00"},
+    {2099, 12, 31, 23, 59, 59, 3155759999u, "12/31/2099 23:59:59"}, // Last second the DS1302 can hold
+};
+
+// Checks toEpochTime() and epochToString() against the table above, then every day of
+// the DS1302's range against the C library's timegm()
+static int checkEpochTime()
+{
+    unsigned long failures = 0;
+    char text[TIME_STRING_SIZE];
+    for (const KnownEpoch &known : knownEpochs)
+    {
+        RtcDateTime dt(known.year, known.month, known.day, known.hour, known.minute, known.second);
+        EpochTime epoch = toEpochTime(dt);
+        epochToString(epoch, text, sizeof(text));
+        if (epoch != known.expected || strcmp(text, known.text) != 0)
+        {
+            printf("  %s: got %lu \"%s\", expected %lu\n", known.text, (unsigned long)epoch, text,
+                   (unsigned long)known.expected);
+            failures++;
+        }
+    }
+
+    unsigned long days = 0;
+    for (uint16_t year = 2000; year <= 2099; year++)
+    {
+        for (uint8_t month = 1; month <= 12; month++)
+        {
+            for (uint8_t day = 1; day <= 31; day++)
+            {
+                struct tm calendar = {};
+                calendar.tm_year = year - 1900;
+                calendar.tm_mon = month - 1;
+                calendar.tm_mday = day;
+                calendar.tm_hour = 23;
+                calendar.tm_min = 59;
+                calendar.tm_sec = 59;
+                time_t unixTime = timegm(&calendar);
+                if (calendar.tm_mon != month - 1)
+                {
+                    break; // timegm() normalised a day past the end of the month
+                }
+
+                RtcDateTime dt(year, month, day, 23, 59, 59);
+                EpochTime expected = (EpochTime)(unixTime - c_UnixEpoch32);
+                EpochTime epoch = toEpochTime(dt);
+                if (epoch != expected || RtcDateTime(epoch).TotalSeconds() != expected)
+                {
+                    if (failures < 10)
+                    {
+                        printf("  %02u/%02u/%04u 23:59:59: got %lu, expected %lu\n", month, day, year,
+                               (unsigned long)epoch, (unsigned long)expected);
+                    }
+                    failures++;
+                }
+                days++;
+            }
+        }
+    }
+
+    printf("Epoch time: %zu known dates and %lu days of 2000-2099 checked, %lu failures\n",
+           sizeof(knownEpochs) / sizeof(knownEpochs[0]), days, failures);
+    return failures == 0 ? 0 : 1;
+}
+
+// Old member snapshot layouts, as written by earlier firmware (see store_utils.cpp)
+struct FixtureHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t count;
+    uint32_t crc;
+};
+
+struct FixtureMemberV1
+{
+    uint8_t uid[UID_MAX_BYTES];
+    uint8_t uidSize;
+    uint8_t flags;
+    int32_t lastLogTimeInt;
+    int32_t lastTimeSpent;
+    char name[STORED_NAME_SIZE];
+    char lastLogTime[20];
+    uint32_t crc;
+};
+
+struct FixtureMemberV2
+{
+    uint8_t uid[UID_MAX_BYTES];
+    uint8_t uidSize;
+    uint8_t flags;
+    uint32_t lastLogTime;
+    int32_t lastTimeSpent;
+    char name[STORED_NAME_SIZE];
+    uint32_t crc;
+};
+
+static_assert(sizeof(FixtureMemberV1) == 68 && sizeof(FixtureMemberV2) == 48, "fixture layouts changed");
+
+#define FIXTURE_MAGIC 0x53474442 // "BDGS"
+#define FIXTURE_HAS_ACCESS 0x01
+#define FIXTURE_LOGGED 0x02
+
+// One member of the migration fixture and what it must load as
+struct FixtureMember
+{
+    CardUid uid;
+    uint8_t flags;
+    const char *lastLogText; // Version 1 only
+    EpochTime lastLogTime;
+    int32_t lastTimeSpent;
+    const char *name;
+};
+
+static const FixtureMember fixtureMembers[] = {
+    {{{0x04, 0xA1, 0xB2, 0xC3, 0xD4, 0xE5, 0xF6}, 7}, FIXTURE_HAS_ACCESS | FIXTURE_LOGGED, "02/29/2024 17:30:00",
+     762543000, 3600, "Ada Lovelace"},
+    {{{0x5E, 0x11, 0x22, 0x33}, 4}, 0, "", 0, 0, "Bob Builder"}, // Never logged, access revoked
+    {{{0x9C, 0x01, 0x02, 0x03}, 4}, FIXTURE_HAS_ACCESS, "12/31/2099 23:59:59", 3155759999u, 59, "Carol Danvers"},
+};
+
+// Function to write a version 1 or 2 snapshot of the fixture members into `dir`, with a
+// corrupt record after them that the migration must drop
+static void writeLegacySnapshot(const std::string &dir, uint16_t version)
+{
+    const uint32_t count = sizeof(fixtureMembers) / sizeof(fixtureMembers[0]);
+    FixtureHeader header = {FIXTURE_MAGIC, version,
+                            (uint16_t)(version == 1 ? sizeof(FixtureMemberV1) : sizeof(FixtureMemberV2)), count + 1, 0};
+    header.crc = crc32(&header, offsetof(FixtureHeader, crc));
+
+    FILE *file = fopen((dir + "/members.bin").c_str(), "wb");
+    fwrite(&header, sizeof(header), 1, file);
+    for (uint32_t i = 0; i <= count; i++)
+    {
+        const FixtureMember &member = fixtureMembers[i % count];
+        if (version == 1)
+        {
+            FixtureMemberV1 record = {};
+            memcpy(record.uid, member.uid.bytes, UID_MAX_BYTES);
+            record.uidSize = member.uid.size;
+            record.flags = member.flags;
+            record.lastLogTimeInt = 12345; // Seconds of the year, ignored by the migration
+            record.lastTimeSpent = member.lastTimeSpent;
+            snprintf(record.name, sizeof(record.name), "%s", member.name);
+            snprintf(record.lastLogTime, sizeof(record.lastLogTime), "%s", member.lastLogText);
+            record.crc = crc32(&record, offsetof(FixtureMemberV1, crc)) + (i == count);
+            fwrite(&record, sizeof(record), 1, file);
+        }
+        else
+        {
+            FixtureMemberV2 record = {};
+            memcpy(record.uid, member.uid.bytes, UID_MAX_BYTES);
+            record.uidSize = member.uid.size;
+            record.flags = member.flags;
+            record.lastLogTime = member.lastLogTime;
+            record.lastTimeSpent = member.lastTimeSpent;
+            snprintf(record.name, sizeof(record.name), "%s", member.name);
+            record.crc = crc32(&record, offsetof(FixtureMemberV2, crc)) + (i == count);
+            fwrite(&record, sizeof(record), 1, file);
+        }
+    }
+    fclose(file);
+}
+
+// Function to load a version 1 or 2 fixture snapshot and check every migrated member
+// and the snapshot written back. Returns the number of mismatches.
+static unsigned long checkMigration(uint16_t version)
+{
+    std::string dir = makeStoreDir();
+    writeLegacySnapshot(dir, version);
+
+    // Leave stale statistics behind so a migration that fails to clear them shows
+    for (int i = 0; i < MAX_UIDS; i++)
+    {
+        memset(&details_db[i].stats, 0xA5, sizeof(details_db[i].stats));
+    }
+    sim::setStoreDir(dir.c_str());
+    loadMembers();
+
+    const int count = sizeof(fixtureMembers) / sizeof(fixtureMembers[0]);
+    const sessionStats noStats = {};
+    unsigned long failures = 0;
+    if (uidCount != count)
+    {
+        printf("  v%u: loaded %d members, expected %d\n", version, uidCount, count);
+        failures++;
+    }
+    for (int i = 0; i < std::min(uidCount, count); i++)
+    {
+        const FixtureMember &member = fixtureMembers[i];
+        const memberDetails &details = details_db[i];
+        if (!(memberUids[i] == member.uid) || memberHasAccess(i) != ((member.flags & FIXTURE_HAS_ACCESS) != 0) ||
+            memberLogged(i) != ((member.flags & FIXTURE_LOGGED) != 0) || details.lastLogTime != member.lastLogTime ||
+            details.lastTimeSpent != member.lastTimeSpent || strcmp(details.name, member.name) != 0 ||
+            memcmp(&details.stats, &noStats, sizeof(noStats)) != 0)
+        {
+            printf("  v%u: member %d \"%s\" migrated wrongly (last log %lu, spent %d)\n", version, i, details.name,
+                   (unsigned long)details.lastLogTime, details.lastTimeSpent);
+            failures++;
+        }
+    }
+
+    // The snapshot must have been rewritten in the current layout
+    FixtureHeader header = {};
+    FILE *file = fopen((dir + "/members.bin").c_str(), "rb");
+    size_t headerRead = file ? fread(&header, sizeof(header), 1, file) : 0;
+    if (file)
+    {
+        fclose(file);
+    }
+    if (headerRead != 1 || header.version != 3 || header.recordSize != 80 || header.count != (uint32_t)count)
+    {
+        printf("  v%u: snapshot not rewritten (version %u, record size %u, %lu records)\n", version, header.version,
+               header.recordSize, (unsigned long)header.count);
+        failures++;
+    }
+
+    removeStoreDir(dir);
+    return failures;
+}
+
+// Function to return the size of a file in the store directory, -1 if it is missing
+static long storeFileSize(const std::string &dir, const char *name)
+{
+    FILE *file = fopen((dir + "/" + name).c_str(), "rb");
+    if (!file)
+    {
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+// Function to boot from a snapshot with a sound header this build cannot load, and check
+// that neither the boot nor a later change touches it. Returns the number of mismatches.
+static unsigned long checkUnreadableSnapshot(uint16_t version, uint16_t recordSize, uint32_t count)
+{
+    std::string dir = makeStoreDir();
+    FixtureHeader header = {FIXTURE_MAGIC, version, recordSize, count, 0};
+    header.crc = crc32(&header, offsetof(FixtureHeader, crc));
+    FILE *file = fopen((dir + "/members.bin").c_str(), "wb");
+    fwrite(&header, sizeof(header), 1, file);
+    fclose(file);
+
+    sim::setStoreDir(dir.c_str());
+    loadMembers();
+    storeMember(0);
+
+    FixtureHeader after = {};
+    file = fopen((dir + "/members.bin").c_str(), "rb");
+    size_t headerRead = fread(&after, sizeof(after), 1, file);
+    fclose(file);
+    unsigned long failures = 0;
+    if (headerRead != 1 || memcmp(&after, &header, sizeof(header)) != 0 || storeFileSize(dir, "members.log") > 0)
+    {
+        printf("  snapshot version %u, %lu members: overwritten\n", version, (unsigned long)count);
+        failures++;
+    }
+    removeStoreDir(dir);
+    return failures;
+}
+
+static int checkStoreMigration()
+{
+    Serial.setOutput(nullptr);
+    unsigned long failures = checkMigration(1) + checkMigration(2);
+    failures += checkUnreadableSnapshot(4, 96, 10);          // From a newer firmware
+    failures += checkUnreadableSnapshot(3, 80, MAX_UIDS + 1); // From a larger configuration
+    printf("Store migration: version 1 and 2 snapshots of %zu members loaded, unreadable ones kept, %lu failures\n",
+           sizeof(fixtureMembers) / sizeof(fixtureMembers[0]), failures);
+    return failures == 0 ? 0 : 1;
+}
+
+// Checks that a journal ending in a record cut short by a power cut is compacted at boot,
+// so the changes appended after it still load on the next boot
+static int checkTornJournal()
+{
+    Serial.setOutput(nullptr);
+    unsigned long failures = 0;
+    std::string dir = makeStoreDir();
+    sim::setStoreDir(dir.c_str());
+    loadMembers();
+    enrollMembers(4);
+
+    // One good record, then part of the next as a power cut would leave it
+    snprintf(details_db[0].name, sizeof(details_db[0].name), "Renamed before the cut");
+    storeMember(0);
+    FILE *journal = fopen((dir + "/members.log").c_str(), "ab");
+    fwrite("partial", 7, 1, journal);
+    fclose(journal);
+
+    loadMembers();
+    if (strcmp(details_db[0].name, "Renamed before the cut") != 0 || storeFileSize(dir, "members.log") != 0)
+    {
+        printf("  torn journal: not compacted at boot (journal %ld bytes)\n", storeFileSize(dir, "members.log"));
+        failures++;
+    }
+
+    // A change made after that boot must survive the next one
+    snprintf(details_db[1].name, sizeof(details_db[1].name), "Renamed after the cut");
+    storeMember(1);
+    snprintf(details_db[1].name, sizeof(details_db[1].name), "Lost");
+    loadMembers();
+    if (strcmp(details_db[1].name, "Renamed after the cut") != 0)
+    {
+        printf("  torn journal: change after the cut loaded as \"%s\"\n", details_db[1].name);
+        failures++;
+    }
+
+    removeStoreDir(dir);
+    printf("Torn journal: %lu failures\n", failures);
+    return failures == 0 ? 0 : 1;
+}
+
+// Function to report a clock check that failed
+static unsigned long clockFailure(const char *what, EpochTime clock, const RtcDateTime &rtc)
+{
+    char clockText[TIME_STRING_SIZE];
+    printf("  %s: clock %s, RTC %s\n", what, epochToString(clock, clockText, sizeof(clockText)),
+           rtc.IsValid() ? "valid" : "invalid");
+    return 1;
+}
+
+// Checks that startClock() keeps a valid RTC time, seeds the clock and the RTC when the
+// RTC has lost its time, and that a resync finding it lost writes the clock back to it
+static int checkClockSeeding()
+{
+    Serial.setOutput(nullptr);
+    unsigned long failures = 0;
+    const EpochTime rtcTime = toEpochTime(RtcDateTime(2025, 3, 3, 8, 0, 0));
+
+    // A valid RTC is taken as is and not written
+    sim::setRtcTime(rtcTime);
+    unsigned long invalid = clockStats.invalid;
+    startClock();
+    RtcDateTime rtc = Rtc.GetDateTime();
+    if (clockNow() != rtcTime || toEpochTime(rtc) != rtcTime || clockStats.invalid != invalid)
+    {
+        failures += clockFailure("valid RTC at boot", clockNow(), rtc);
+    }
+
+    // A lost RTC is set to the build time, and the clock starts from what was written
+    sim::setRtcTimeLost();
+    startClock();
+    rtc = Rtc.GetDateTime();
+    EpochTime seeded = clockNow();
+    if (!rtc.IsValid() || rtc.Year() < 2025 || (EpochTime)(toEpochTime(rtc) - seeded) > 1 ||
+        clockStats.invalid != invalid + 1)
+    {
+        failures += clockFailure("lost RTC at boot", seeded, rtc);
+    }
+
+    // Losing the time while running: the resync keeps the clock going and restores the RTC
+    sim::setRtcTimeLost();
+    sim::advanceUs(CLOCK_RESYNC_MS * 1000ULL);
+    updateClock();
+    rtc = Rtc.GetDateTime();
+    EpochTime resynced = clockNow();
+    if (resynced - seeded < CLOCK_RESYNC_MS / 1000 || !rtc.IsValid() ||
+        (EpochTime)(toEpochTime(rtc) - resynced) > 1 || clockStats.invalid != invalid + 2)
+    {
+        failures += clockFailure("RTC lost while running", resynced, rtc);
+    }
+
+    printf("Clock: boot with a valid and a lost RTC and a resync with a lost RTC, %lu failures\n", failures);
+    return failures == 0 ? 0 : 1;
+}
+
+// Checks the firmware's AES-GCM backend and the portable implementation the decoder uses
+// against the GCM specification's known answers
+static int checkCrypto()
+{
+    int firmwareFailed = cryptoSelfTest() ? 0 : 1;
+    AesGcm portable;
+    int portableFailed = aesGcmKnownAnswers(
+        [&](const uint8_t *key) {
+            portable.setKey(key);
+            return true;
+        },
+        [&](const uint8_t *nonce, const uint8_t *aad, size_t aadLength, uint8_t *data, size_t length, uint8_t *tag) {
+            portable.seal(nonce, aad, aadLength, data, length, tag);
+            return true;
+        },
+        [&](const uint8_t *nonce, const uint8_t *aad, size_t aadLength, uint8_t *data, size_t length,
+            const uint8_t *tag) { return portable.open(nonce, aad, aadLength, data, length, tag); });
+
+    printf("AES-128-GCM known answers: %zu vectors, firmware backend (%s) %s, portable %d failures\n",
+           sizeof(aesGcmVectors) / sizeof(aesGcmVectors[0]), cryptoBackend(), firmwareFailed ? "failed" : "passed",
+           portableFailed);
+    return firmwareFailed == 0 && portableFailed == 0 ? 0 : 1;
+}
+
+static int runChecks()
+{
+    int failed = checkEpochTime();
+    failed |= checkStoreMigration();
+    failed |= checkTornJournal();
+    failed |= checkClockSeeding();
+    failed |= checkCrypto();
+    return failed;
+}
+
+int main(int argc, char **argv)
+{
+    const char *mode = argc > 1 ? argv[1] : "";
+    const char *serialPath = nullptr;
+    const char *storeDir = nullptr;
+    int members = 1000;
+    unsigned long items = 10000000;
+    int hours = 2;
+
+    for (int i = 2; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--serial" && i + 1 < argc)
+            serialPath = argv[++i];
+        else if (option == "--store" && i + 1 < argc)
+            storeDir = argv[++i];
+        else if (option == "--members" && i + 1 < argc)
+            members = atoi(argv[++i]);
+        else if (option == "--items" && i + 1 < argc)
+            items = strtoul(argv[++i], nullptr, 10);
+        else if (option == "--hours" && i + 1 < argc)
+            hours = std::max(1, atoi(argv[++i]));
+        else
+            mode = "";
+    }
+    members = std::max(1, std::min(members, MAX_UIDS));
+
+    if (strcmp(mode, "demo") == 0)
+    {
+        return runDemo(serialPath, storeDir);
+    }
+    if (strcmp(mode, "bench") == 0)
+    {
+        return runBench(members, storeDir);
+    }
+    if (strcmp(mode, "roster") == 0)
+    {
+        return runRosterBench(members, storeDir);
+    }
+    if (strcmp(mode, "soak") == 0)
+    {
+        return runSoak(members, hours, storeDir);
+    }
+    if (strcmp(mode, "queue-stress") == 0)
+    {
+        return runQueueStress(items);
+    }
+    if (strcmp(mode, "check") == 0)
+    {
+        return runChecks();
+    }
+
+    fprintf(stderr, "usage: %s demo [--serial FILE] [--store DIR]\n"
+                    "       %s bench [--members N] [--store DIR]\n"
+                    "       %s roster [--members N] [--store DIR]\n"
+                    "       %s soak [--members N] [--hours N] [--store DIR]\n"
+                    "       %s queue-stress [--items N]\n"
+                    "       %s check\n",
+            argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+    return 2;
+}
@@ -0,0 +1,149 @@
+// Virtual clock, scheduled harness actions and pin state
+#include <sim.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sim
+{
+static uint64_t clockUs = 0; // Main core, where setup() and loop() run
+
+// Background tasks, each with its own clock.
+// Every task runs on a host thread of its own, but only one thread (the main core or one
+// task) runs at a time: the running one holds the baton and hands it back whenever its
+// clock moves. A task therefore stops at every advanceUs() and the main core decides who
+// goes next, so nothing a task does becomes visible before the main core's clock has
+// reached the task's time. (Running a whole step at once would let loop() see a scan
+// before its clock got to the read.)
+struct service
+{
+    std::function<void()> step;
+    uint64_t clockUs;
+};
+static std::deque<service> services; // A deque, so starting a task never moves a running one
+static int runningService = -1; // Task holding the baton, -1 for the main core
+
+// Never destroyed, so threads still parked at exit do not outlive them
+static std::mutex &batonMutex = *new std::mutex;
+static std::condition_variable &batonChanged = *new std::condition_variable;
+
+static std::multimap<uint64_t, std::function<void()>> actions;
+
+static int pinLevels[256];
+static int analogLevels[256];
+
+static std::string storeRoot = ".";
+
+uint64_t nowUs() { return runningService < 0 ? clockUs : services[runningService].clockUs; }
+
+// Function to hand the baton to task `index` and wait until it hands it back
+static void resumeService(int index)
+{
+    std::unique_lock<std::mutex> lock(batonMutex);
+    runningService = index;
+    batonChanged.notify_all();
+    batonChanged.wait(lock, []() { return runningService < 0; });
+}
+
+// Function for the running task to hand the baton back to the main core and wait until it
+// is its turn again
+static void yieldService()
+{
+    int self = runningService;
+    std::unique_lock<std::mutex> lock(batonMutex);
+    runningService = -1;
+    batonChanged.notify_all();
+    batonChanged.wait(lock, [self]() { return runningService == self; });
+}
+
+static void serviceThread(int index)
+{
+    {
+        std::unique_lock<std::mutex> lock(batonMutex);
+        batonChanged.wait(lock, [index]() { return runningService == index; });
+    }
+    for (;;)
+    {
+        uint64_t before = services[index].clockUs;
+        services[index].step();
+        if (services[index].clockUs == before)
+        {
+            services[index].clockUs++; // A step that touched no device still takes some time
+            yieldService();
+        }
+    }
+}
+
+// Function to let the background tasks run until each clock reaches `targetUs`, always
+// resuming the task that is furthest behind so they meet devices and actions in order
+static void runServices(uint64_t targetUs)
+{
+    for (;;)
+    {
+        int next = -1;
+        for (size_t i = 0; i < services.size(); i++)
+        {
+            if (services[i].clockUs < targetUs && (next < 0 || services[i].clockUs < services[next].clockUs))
+            {
+                next = (int)i;
+            }
+        }
+        if (next < 0)
+        {
+            break;
+        }
+
+        resumeService(next);
+    }
+}
+
+void advanceUs(uint64_t us)
+{
+    // A background task only moves its own clock, then lets the main core catch up
+    if (runningService >= 0)
+    {
+        services[runningService].clockUs += us;
+        yieldService();
+        return;
+    }
+
+    // Bring the tasks up to each action before firing it, so they see harness actions
+    // at the right time. Actions may schedule further actions, so take them one at a time.
+    uint64_t target = clockUs + us;
+    while (!actions.empty() && actions.begin()->first <= target)
+    {
+        auto next = actions.begin();
+        uint64_t at = next->first > clockUs ? next->first : clockUs;
+        runServices(at);
+        clockUs = at;
+        std::function<void()> action = std::move(next->second);
+        actions.erase(next);
+        action();
+    }
+    runServices(target);
+    clockUs = target;
+}
+
+void schedule(uint64_t atUs, std::function<void()> action) { actions.emplace(atUs, std::move(action)); }
+
+void startService(const char *name, std::function<void()> step)
+{
+    (void)name;
+    services.push_back({std::move(step), clockUs});
+    std::thread(serviceThread, (int)services.size() - 1).detach();
+}
+
+void setPinLevel(uint8_t pin, int level) { pinLevels[pin] = level; }
+int pinLevel(uint8_t pin) { return pinLevels[pin]; }
+void setAnalogLevel(uint8_t pin, int level) { analogLevels[pin] = level; }
+int analogLevel(uint8_t pin) { return analogLevels[pin]; }
+
+void setStoreDir(const char *dir) { storeRoot = dir; }
+const char *storeDir() { return storeRoot.c_str(); }
+} // namespace sim
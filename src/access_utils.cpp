@@ -1,180 +1,252 @@
-#include <utils.hpp>
-
-// Function to convert a UID to a string
-String convertUID(MFRC522 &mfrc522)
-{
-    // Read the UID from the card
-    String readUID = "";
-    for (byte i = 0; i < mfrc522.uid.size; i++)
-    {
-        // Convert the UID to a string
-        readUID += String(mfrc522.uid.uidByte[i] < 0x10 ? "0" : "") + String(mfrc522.uid.uidByte[i], HEX);
-    }
-    readUID.toUpperCase();
-
-    return readUID;
-}
-
-// Function to convert a UID to an index based on authorized members
-int uidToIndex(String uid)
-{
-    for (int i = 0; i < uidCount; i++)
-    {
-        if (users_db[i].uid == uid)
-        {
-            return i;
-        }
-    }
-
-    return -1;
-}
-
-// Function to add card access
-void addCardAccess()
-{
-    lcd.clear();
-    lcd.print("Scan new card...");
-    // Wait for a new card to be present
-    while (!mfrc522.PICC_IsNewCardPresent())
-    {
-        // Check if the joystick goes to exit
-        int joyY = analogRead(JOYSTICK_URX_PIN);
-        if (joyY > UPPER_JOYSTICK_THRESHOLD)
-        {
-            // Exit add card mode
-            lcd.clear();
-            lcd.print("Exiting...");
-            delay(1000);
-            return;
-        }
-
-        // Wait for a new card to be present
-        delay(100);
-    }
-
-    // Read the card serial
-    if (mfrc522.PICC_ReadCardSerial())
-    {
-        // Convert the UID to a string
-        String newUID = convertUID(mfrc522);
-        // Get the uid associated index
-        int target = uidToIndex(newUID);
-        if (target >= 0)
-        {
-            // Check if the member already exists
-            for (int index = 0; index < uidCount; index++)
-            {
-                if (index == target)
-                {
-                    lcd.clear();
-                    lcd.print("Card exists");
-                    lcd.setCursor(0, 1);
-                    lcd.print("Adding access..");
-                    users_db[index].hasAccess = true;
-                    delay(2000);
-                    lcd.clear();
-                    return;
-                }
-            }
-        }
-
-        // Add the new card to the list
-        users_db[uidCount].uid = newUID;
-        users_db[uidCount].logged = false;
-        users_db[uidCount].hasAccess = true;
-        users_db[uidCount].lastLogTime = "";
-        users_db[uidCount].lastLogTimeInt = 0;
-        users_db[uidCount].lastTimeSpent = 0;
-
-        uidCount++;
-
-        // Print the card added message
-        lcd.clear();
-        lcd.print("Card Added:");
-        lcd.setCursor(0, 1);
-        lcd.print(newUID);
-        delay(2000);
-    }
-    else
-    {
-        // Print the card read error message
-        lcd.clear();
-        lcd.print("Card Read Error");
-        delay(2000);
-    }
-}
-
-// Function to remove card access
-void removeCardAccess()
-{
-    // Print the remove card message
-    lcd.clear();
-    lcd.print("Scan card to");
-    lcd.setCursor(0, 1);
-    lcd.print("Remove");
-
-    // Wait for a new card to be present
-    while (!mfrc522.PICC_IsNewCardPresent())
-    {
-        // Check if the joystick goes to exit
-        int joyY = analogRead(JOYSTICK_URX_PIN);
-        if (joyY > UPPER_JOYSTICK_THRESHOLD)
-        {
-            // Exit remove card mode
-            lcd.clear();
-            lcd.print("Exiting...");
-            delay(1000);
-            return;
-        }
-        // Wait for a new card to be present
-        delay(100);
-    }
-
-    // Read the card serial
-    if (mfrc522.PICC_ReadCardSerial())
-    {
-        String removeUID = convertUID(mfrc522);
-        // Get the uid associated index
-        int index = uidToIndex(removeUID);
-        if (index >= 0)
-        {
-            // Just set the member as having access to false
-            users_db[index].hasAccess = false;
-
-            // Print the card removed message
-            lcd.clear();
-            lcd.print("Card Removed:");
-            lcd.setCursor(0, 1);
-            lcd.print(removeUID);
-            delay(2000);
-        }
-        else
-        {
-            // Print the member not found message
-            lcd.clear();
-            lcd.print("Member Not Found");
-            delay(2000);
-        }
-    }
-    else
-    {
-        // Print the card read error message
-        lcd.clear();
-        lcd.print("Card Read Error");
-        delay(2000);
-    }
-}
-
-// Function to check if a UID is authorized
-bool isAuthorizedUID(String uid)
-{
-    for (int i = 0; i < uidCount; i++)
-    {
-        if (users_db[i].uid == uid && users_db[i].hasAccess == true)
-        {
-            Serial.println("Member with id: " + uid + " has access");
-            return true;
-        }
-    }
-    return false;
-}
+#include <utils.hpp>
+#include <denied_cards.hpp>
+
+// Denied cards.
+// Cards denied in the last DENIED_CACHE_MS are answered from a small negative cache
+// without probing the member index; granting access to any card empties it. Separately,
+// only DENIED_FEEDBACK_MAX denials per DENIED_WINDOW_MS get the melody and the Access
+// Denied screen. The rest are only counted, so a stack of foreign cards swept past the
+// reader cannot keep the buzzer and display busy.
+static DeniedCards<DENIED_CACHE_SLOTS> deniedCards;
+
+DenialStats denialStats = {0, 0, 0};
+
+// Function to copy the UID reported by the reader into a CardUid.
+// Works on the raw bytes, so no hex conversion or heap allocation happens per scan.
+CardUid convertUID(const MFRC522::Uid &readerUid)
+{
+    CardUid uid;
+    uid.size = readerUid.size <= UID_MAX_BYTES ? readerUid.size : UID_MAX_BYTES;
+    memcpy(uid.bytes, readerUid.uidByte, uid.size);
+    return uid;
+}
+
+// Function to look up a UID in the member index.
+// Returns the member index together with its access status from a single hash probe.
+MemberLookup lookupMember(const CardUid &uid)
+{
+    int index = memberIndex.find(uid);
+    return {index, index >= 0 && memberHasAccess(index)};
+}
+
+// Function to check a scanned card's access, answering recently denied cards from the
+// negative cache. Cards found without access are added to it.
+MemberLookup checkMemberAccess(const CardUid &uid)
+{
+    unsigned long now = millis();
+    if (deniedCards.contains(uid, now, DENIED_CACHE_MS))
+    {
+        denialStats.cached++;
+        return {-1, false};
+    }
+
+    MemberLookup member = lookupMember(uid);
+    if (!member.hasAccess)
+    {
+        deniedCards.add(uid, now);
+    }
+    return member;
+}
+
+// Function to count a denial and decide whether it still gets the full feedback.
+// Returns false once DENIED_FEEDBACK_MAX denials have been shown in the current window.
+bool allowDenialFeedback()
+{
+    static unsigned long windowStart = 0;
+    static unsigned int shownInWindow = 0;
+
+    denialStats.denied++;
+    unsigned long now = millis();
+    if (now - windowStart >= DENIED_WINDOW_MS)
+    {
+        windowStart = now;
+        shownInWindow = 0;
+    }
+    if (shownInWindow >= DENIED_FEEDBACK_MAX)
+    {
+        denialStats.limited++;
+        return false;
+    }
+    shownInWindow++;
+    return true;
+}
+
+// Function to forget all denied cards, called whenever a card is granted access
+void forgetDeniedCards()
+{
+    deniedCards.clear();
+}
+
+// Function to (re)build the member index from memberUids, called once at startup
+void buildMemberIndex()
+{
+    memberIndex.clear();
+    for (int i = 0; i < uidCount; i++)
+    {
+        memberIndex.insert(i);
+    }
+}
+
+// Function to grant or revoke a member's access and persist the change
+void setMemberAccess(int index, bool hasAccess)
+{
+    bitsetAssign(memberAccessBits, index, hasAccess);
+    if (hasAccess)
+    {
+        forgetDeniedCards();
+    }
+    storeMember(index);
+}
+
+// Function to mark a member as present or gone at `timestamp`, keeping occupancy in step
+void setMemberLogged(int index, bool logged, EpochTime timestamp)
+{
+    if (memberLogged(index) == logged)
+    {
+        return;
+    }
+    bitsetAssign(memberLoggedBits, index, logged);
+    recordOccupancyChange(logged ? 1 : -1, timestamp);
+}
+
+// Function to print the per-member RAM cost of the member table on serial
+void printMemberFootprint()
+{
+    Serial.print("Member RAM: hot ");
+    Serial.print(MEMBER_HOT_BYTES);
+    Serial.print(" B + cold ");
+    Serial.print(MEMBER_COLD_BYTES);
+    Serial.print(" B per member, ");
+    Serial.print((unsigned long)(MAX_UIDS * (MEMBER_HOT_BYTES + MEMBER_COLD_BYTES)));
+    Serial.print(" B for ");
+    Serial.print(MAX_UIDS);
+    Serial.println(" members");
+}
+
+// Function to convert a UID to an index based on authorized members
+int uidToIndex(const CardUid &uid)
+{
+    return lookupMember(uid).index;
+}
+
+// Function to copy `name` into a member's details, cut to fit
+static void setMemberName(int index, const char *name)
+{
+    strncpy(details_db[index].name, name, sizeof(details_db[index].name) - 1);
+    details_db[index].name[sizeof(details_db[index].name) - 1] = '\0';
+}
+
+// Function to grant access to a card: a known card gets its access back, an unknown one
+// is enrolled as a new member. A non-NULL `name` is set before the member is stored, so
+// each grant journals one record. Returns the member index, or -1 if the member list is
+// full.
+int grantCardAccess(const CardUid &newUID, const char *name, bool &enrolled)
+{
+    enrolled = false;
+
+    // Get the uid associated index
+    int target = uidToIndex(newUID);
+    if (target >= 0)
+    {
+        // The member already exists, just give access back
+        if (name != NULL)
+        {
+            setMemberName(target, name);
+        }
+        setMemberAccess(target, true);
+        return target;
+    }
+
+    // Check there is room for another member
+    if (uidCount >= MAX_UIDS)
+    {
+        return -1;
+    }
+
+    // Add the new card to the list
+    memberUids[uidCount] = newUID;
+    bitsetAssign(memberLoggedBits, uidCount, false);
+    bitsetAssign(memberAccessBits, uidCount, true);
+    memset(&details_db[uidCount], 0, sizeof(memberDetails));
+    if (name != NULL)
+    {
+        setMemberName(uidCount, name);
+    }
+
+    memberIndex.insert(uidCount);
+    forgetDeniedCards();
+
+    uidCount++;
+    storeMember(uidCount - 1);
+    enrolled = true;
+    return uidCount - 1;
+}
+
+// Function to grant access to a card scanned on the Add Access page, queueing the outcome
+// as a feedback screen
+void addCardAccess(const CardUid &newUID)
+{
+    startFeedback();
+
+    // The roster being received is applied in one go once it is complete, and access
+    // changes wait for it so they are not overwritten by it
+    bool enrolled;
+    if (rosterImportActive())
+    {
+        addFeedbackScreen("Roster loading", "Try again later", 2000);
+    }
+    else if (grantCardAccess(newUID, NULL, enrolled) < 0)
+    {
+        addFeedbackScreen("Member list full", "", 2000);
+    }
+    else if (!enrolled)
+    {
+        addFeedbackScreen("Card exists", "Adding access..", 2000);
+    }
+    else
+    {
+        // Show the card added message
+        char uidHex[UID_HEX_SIZE];
+        addFeedbackScreen("Card Added:", formatCardUid(newUID, uidHex), 2000);
+    }
+}
+
+// Function to revoke the access of a card scanned on the Remove Access page, queueing
+// the outcome as a feedback screen
+void removeCardAccess(const CardUid &removeUID)
+{
+    startFeedback();
+
+    // Get the uid associated index
+    int index = uidToIndex(removeUID);
+    if (rosterImportActive())
+    {
+        addFeedbackScreen("Roster loading", "Try again later", 2000);
+    }
+    else if (index >= 0)
+    {
+        // Just set the member as having access to false
+        setMemberAccess(index, false);
+
+        char uidHex[UID_HEX_SIZE];
+        addFeedbackScreen("Card Removed:", formatCardUid(removeUID, uidHex), 2000);
+    }
+    else
+    {
+        addFeedbackScreen("Member Not Found", "", 2000);
+    }
+}
+
+// Function to check if a UID is authorized
+bool isAuthorizedUID(const CardUid &uid)
+{
+    MemberLookup member = lookupMember(uid);
+    if (member.hasAccess)
+    {
+        Serial.print("Member ");
+        Serial.print(member.index);
+        Serial.println(" has access");
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,352 @@
+#ifndef AES_GCM_HPP
+#define AES_GCM_HPP
+
+// Portable AES-128-GCM (NIST SP 800-38D), for builds without mbedTLS and for the host
+// tools. Written for clarity rather than speed: the cipher works a byte at a time from the
+// S-box and GHASH multiplies bit by bit, so it needs no tables beyond the S-box. The
+// firmware uses mbedTLS, and with it the ESP32's AES peripheral, wherever that is
+// available (see crypto_utils.cpp). Only depends on the C standard headers.
+//
+// A buffer is sealed in one call: it is encrypted in place in counter mode and a 16-byte
+// tag authenticates it together with some associated data (AAD) that stays in clear.
+// Every nonce must be used only once with a given key.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define AES_BLOCK_BYTES 16
+#define AES_KEY_BYTES 16      // AES-128
+#define AES_KEY_HEX_SIZE 33   // Hex string of a key, including the terminator
+#define AES_GCM_NONCE_BYTES 12
+#define AES_GCM_TAG_BYTES 16
+
+static const uint8_t aesSbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76, //
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0, //
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15, //
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75, //
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84, //
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf, //
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8, //
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2, //
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73, //
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb, //
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79, //
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08, //
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a, //
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e, //
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf, //
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16, //
+};
+
+// Function to multiply by x in GF(2^8), the AES field
+inline uint8_t aesXtime(uint8_t value)
+{
+    return (uint8_t)((value << 1) ^ (0x1b & (0u - (value >> 7))));
+}
+
+// Function to parse exactly `size` bytes written as hex digits. Returns false if the text
+// is anything else.
+inline bool parseHexBytes(const char *hex, uint8_t *out, size_t size)
+{
+    if (strlen(hex) != size * 2)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < size * 2; i++)
+    {
+        char c = hex[i];
+        uint8_t digit = (c >= '0' && c <= '9')   ? c - '0'
+                        : (c >= 'A' && c <= 'F') ? c - 'A' + 10
+                        : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+                                                 : 0xFF;
+        if (digit == 0xFF)
+        {
+            return false;
+        }
+        out[i / 2] = (i % 2 == 0) ? (uint8_t)(digit << 4) : (uint8_t)(out[i / 2] | digit);
+    }
+    return true;
+}
+
+// Function to parse a key written as 32 hex digits. Returns false if the text is not one.
+inline bool parseAesKey(const char *hex, uint8_t key[AES_KEY_BYTES])
+{
+    return parseHexBytes(hex, key, AES_KEY_BYTES);
+}
+
+class AesGcm
+{
+public:
+    // Function to expand `key` into the round keys and derive the GHASH key
+    void setKey(const uint8_t key[AES_KEY_BYTES])
+    {
+        memcpy(roundKeys, key, AES_KEY_BYTES);
+        uint8_t rcon = 1;
+        for (int i = AES_KEY_BYTES; i < (int)sizeof(roundKeys); i += 4)
+        {
+            uint8_t t[4] = {roundKeys[i - 4], roundKeys[i - 3], roundKeys[i - 2], roundKeys[i - 1]};
+            if (i % AES_KEY_BYTES == 0)
+            {
+                uint8_t first = t[0];
+                t[0] = aesSbox[t[1]] ^ rcon;
+                t[1] = aesSbox[t[2]];
+                t[2] = aesSbox[t[3]];
+                t[3] = aesSbox[first];
+                rcon = aesXtime(rcon);
+            }
+            for (int j = 0; j < 4; j++)
+            {
+                roundKeys[i + j] = roundKeys[i - AES_KEY_BYTES + j] ^ t[j];
+            }
+        }
+
+        uint8_t zero[AES_BLOCK_BYTES] = {0};
+        uint8_t hashKey[AES_BLOCK_BYTES];
+        encryptBlock(zero, hashKey);
+        hashKeyHigh = load64(hashKey);
+        hashKeyLow = load64(hashKey + 8);
+    }
+
+    // Function to encrypt `data` in place and compute the tag over `aad` and the ciphertext
+    void seal(const uint8_t nonce[AES_GCM_NONCE_BYTES], const uint8_t *aad, size_t aadLength, uint8_t *data,
+              size_t length, uint8_t tag[AES_GCM_TAG_BYTES]) const
+    {
+        crypt(nonce, data, length);
+        computeTag(nonce, aad, aadLength, data, length, tag);
+    }
+
+    // Function to check the tag and decrypt `data` in place. Returns false, leaving the
+    // data encrypted, if the data or the AAD do not match the tag.
+    bool open(const uint8_t nonce[AES_GCM_NONCE_BYTES], const uint8_t *aad, size_t aadLength, uint8_t *data,
+              size_t length, const uint8_t tag[AES_GCM_TAG_BYTES]) const
+    {
+        uint8_t expected[AES_GCM_TAG_BYTES];
+        computeTag(nonce, aad, aadLength, data, length, expected);
+        uint8_t difference = 0;
+        for (int i = 0; i < AES_GCM_TAG_BYTES; i++)
+        {
+            difference |= expected[i] ^ tag[i];
+        }
+        if (difference != 0)
+        {
+            return false;
+        }
+        crypt(nonce, data, length);
+        return true;
+    }
+
+private:
+    static uint64_t load64(const uint8_t *in)
+    {
+        uint64_t value = 0;
+        for (int i = 0; i < 8; i++)
+        {
+            value = (value << 8) | in[i];
+        }
+        return value;
+    }
+
+    static void store64(uint8_t *out, uint64_t value)
+    {
+        for (int i = 7; i >= 0; i--, value >>= 8)
+        {
+            out[i] = (uint8_t)value;
+        }
+    }
+
+    // Function to encrypt one block with the expanded key
+    void encryptBlock(const uint8_t in[AES_BLOCK_BYTES], uint8_t out[AES_BLOCK_BYTES]) const
+    {
+        uint8_t state[AES_BLOCK_BYTES];
+        for (int i = 0; i < AES_BLOCK_BYTES; i++)
+        {
+            state[i] = in[i] ^ roundKeys[i];
+        }
+        for (int round = 1; round <= 10; round++)
+        {
+            // SubBytes and ShiftRows together: row r of column c comes from column c + r
+            uint8_t t[AES_BLOCK_BYTES];
+            for (int c = 0; c < 4; c++)
+            {
+                for (int r = 0; r < 4; r++)
+                {
+                    t[4 * c + r] = aesSbox[state[4 * ((c + r) & 3) + r]];
+                }
+            }
+            if (round < 10)
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    uint8_t *column = t + 4 * c;
+                    uint8_t a0 = column[0], a1 = column[1], a2 = column[2], a3 = column[3];
+                    uint8_t all = a0 ^ a1 ^ a2 ^ a3;
+                    column[0] = a0 ^ all ^ aesXtime(a0 ^ a1);
+                    column[1] = a1 ^ all ^ aesXtime(a1 ^ a2);
+                    column[2] = a2 ^ all ^ aesXtime(a2 ^ a3);
+                    column[3] = a3 ^ all ^ aesXtime(a3 ^ a0);
+                }
+            }
+            for (int i = 0; i < AES_BLOCK_BYTES; i++)
+            {
+                state[i] = t[i] ^ roundKeys[AES_BLOCK_BYTES * round + i];
+            }
+        }
+        memcpy(out, state, AES_BLOCK_BYTES);
+    }
+
+    // Function to run counter mode over `data`, starting from counter block 2 (block 1
+    // masks the tag)
+    void crypt(const uint8_t nonce[AES_GCM_NONCE_BYTES], uint8_t *data, size_t length) const
+    {
+        uint8_t counter[AES_BLOCK_BYTES];
+        uint8_t keystream[AES_BLOCK_BYTES];
+        memcpy(counter, nonce, AES_GCM_NONCE_BYTES);
+        for (size_t offset = 0, block = 2; offset < length; offset += AES_BLOCK_BYTES, block++)
+        {
+            counter[12] = (uint8_t)(block >> 24);
+            counter[13] = (uint8_t)(block >> 16);
+            counter[14] = (uint8_t)(block >> 8);
+            counter[15] = (uint8_t)block;
+            encryptBlock(counter, keystream);
+            size_t n = length - offset < AES_BLOCK_BYTES ? length - offset : AES_BLOCK_BYTES;
+            for (size_t i = 0; i < n; i++)
+            {
+                data[offset + i] ^= keystream[i];
+            }
+        }
+    }
+
+    // Function to multiply the GHASH accumulator by the hash key in GF(2^128)
+    void multiplyHashKey(uint64_t &high, uint64_t &low) const
+    {
+        uint64_t zHigh = 0, zLow = 0;
+        uint64_t vHigh = hashKeyHigh, vLow = hashKeyLow;
+        for (int i = 0; i < 128; i++)
+        {
+            uint64_t bit = i < 64 ? (high >> (63 - i)) & 1 : (low >> (127 - i)) & 1;
+            uint64_t mask = 0 - bit;
+            zHigh ^= vHigh & mask;
+            zLow ^= vLow & mask;
+            uint64_t carry = vLow & 1;
+            vLow = (vLow >> 1) | (vHigh << 63);
+            vHigh = (vHigh >> 1) ^ (0xE100000000000000ull & (0 - carry));
+        }
+        high = zHigh;
+        low = zLow;
+    }
+
+    // Function to fold `length` bytes, zero padded to whole blocks, into the accumulator
+    void hashBytes(uint64_t &high, uint64_t &low, const uint8_t *data, size_t length) const
+    {
+        for (size_t offset = 0; offset < length; offset += AES_BLOCK_BYTES)
+        {
+            uint8_t block[AES_BLOCK_BYTES] = {0};
+            size_t n = length - offset < AES_BLOCK_BYTES ? length - offset : AES_BLOCK_BYTES;
+            memcpy(block, data + offset, n);
+            high ^= load64(block);
+            low ^= load64(block + 8);
+            multiplyHashKey(high, low);
+        }
+    }
+
+    void computeTag(const uint8_t nonce[AES_GCM_NONCE_BYTES], const uint8_t *aad, size_t aadLength,
+                    const uint8_t *data, size_t length, uint8_t tag[AES_GCM_TAG_BYTES]) const
+    {
+        uint64_t high = 0, low = 0;
+        hashBytes(high, low, aad, aadLength);
+        hashBytes(high, low, data, length);
+        high ^= (uint64_t)aadLength * 8;
+        low ^= (uint64_t)length * 8;
+        multiplyHashKey(high, low);
+
+        uint8_t counter[AES_BLOCK_BYTES] = {0};
+        memcpy(counter, nonce, AES_GCM_NONCE_BYTES);
+        counter[15] = 1;
+        uint8_t mask[AES_BLOCK_BYTES];
+        encryptBlock(counter, mask);
+        store64(tag, high);
+        store64(tag + 8, low);
+        for (int i = 0; i < AES_GCM_TAG_BYTES; i++)
+        {
+            tag[i] ^= mask[i];
+        }
+    }
+
+    uint8_t roundKeys[AES_BLOCK_BYTES * 11];
+    uint64_t hashKeyHigh;
+    uint64_t hashKeyLow;
+};
+
+// --- Known-answer test ---
+
+#define AES_GCM_VECTOR_MAX_BYTES 64
+
+// One AES-128-GCM known answer, all fields as hex
+struct AesGcmVector
+{
+    const char *key;
+    const char *nonce;
+    const char *aad;
+    const char *plain;
+    const char *cipher;
+    const char *tag;
+};
+
+// Test cases 1 to 4 of the GCM specification, the AES-128 vectors NIST SP 800-38D refers
+// to: an empty message, one zero block, four blocks, and a partial block with AAD
+static const AesGcmVector aesGcmVectors[] = {
+    {"00000000000000000000000000000000", "000000000000000000000000", "", "", "", "58e2fccefa7e3061367f1d57a4e7455a"},
+    {"00000000000000000000000000000000", "000000000000000000000000", "", "00000000000000000000000000000000",
+     "0388dace60b6a392f328c2b971b2fe78", "ab6e47d42cec13bdf53a67b21257bddf"},
+    {"feffe9928665731c6d6a8f9467308308", "cafebabefacedbaddecaf888", "",
+     "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+     "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255",
+     "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+     "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091473f5985",
+     "4d5c2af327cd64a62cf35abd2ba6fab4"},
+    {"feffe9928665731c6d6a8f9467308308", "cafebabefacedbaddecaf888", "feedfacedeadbeeffeedfacedeadbeefabaddad2",
+     "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+     "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+     "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+     "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091",
+     "5bc94fbc3221a5db94fae95ae7121a47"},
+};
+
+// Function to run the known answers through an AES-GCM backend. `setKey`, `seal` and
+// `open` take the arguments of AesGcm's members and return whether they succeeded. Each
+// vector is sealed and compared, opened back, and opened again with a damaged tag, which
+// must be refused. Returns the number of vectors that failed.
+template <class SetKey, class Seal, class Open>
+inline int aesGcmKnownAnswers(SetKey setKey, Seal seal, Open open)
+{
+    int failed = 0;
+    for (const AesGcmVector &vector : aesGcmVectors)
+    {
+        uint8_t key[AES_KEY_BYTES], nonce[AES_GCM_NONCE_BYTES], tag[AES_GCM_TAG_BYTES], expectedTag[AES_GCM_TAG_BYTES];
+        uint8_t aad[AES_GCM_VECTOR_MAX_BYTES], plain[AES_GCM_VECTOR_MAX_BYTES], data[AES_GCM_VECTOR_MAX_BYTES],
+            cipher[AES_GCM_VECTOR_MAX_BYTES];
+        size_t aadLength = strlen(vector.aad) / 2;
+        size_t length = strlen(vector.plain) / 2;
+        parseHexBytes(vector.key, key, sizeof(key));
+        parseHexBytes(vector.nonce, nonce, sizeof(nonce));
+        parseHexBytes(vector.aad, aad, aadLength);
+        parseHexBytes(vector.plain, plain, length);
+        parseHexBytes(vector.cipher, cipher, length);
+        parseHexBytes(vector.tag, expectedTag, sizeof(expectedTag));
+
+        memcpy(data, plain, length);
+        bool ok = setKey(key) && seal(nonce, aad, aadLength, data, length, tag) &&
+                  memcmp(data, cipher, length) == 0 && memcmp(tag, expectedTag, sizeof(tag)) == 0;
+        ok = ok && open(nonce, aad, aadLength, data, length, tag) && memcmp(data, plain, length) == 0;
+
+        memcpy(data, cipher, length);
+        tag[0] ^= 1;
+        ok = ok && !open(nonce, aad, aadLength, data, length, tag);
+        failed += !ok;
+    }
+    return failed;
+}
+
+#endif // AES_GCM_HPP
@@ -0,0 +1,197 @@
+#ifndef ATTENDANCE_FRAME_HPP
+#define ATTENDANCE_FRAME_HPP
+
+// Wire format for exporting attendance events in batches.
+// Shared by the firmware (encoder) and the host-side decoder in tools/, so it only
+// depends on the C standard headers.
+//
+// Frame layout, all multi-byte fields little-endian:
+//   0xA5 0x5A            sync
+//   version    (1)       ATTENDANCE_FRAME_VERSION
+//   count      (1)       events in the frame, 1..ATTENDANCE_FRAME_MAX_EVENTS
+//   sequence   (2)       frame counter, lets the collector detect lost frames
+//   nonce      (12)      random, never reused with the key
+//   events     (count * ATTENDANCE_EVENT_BYTES), encrypted as one batch
+//   tag        (16)      AES-128-GCM tag over the events and, in clear, version to nonce
+//   crc        (4)       CRC-32 of everything from version to the tag
+//
+// The CRC lets a collector without the key find frames in the serial stream; the tag is
+// what proves a frame genuine. Version 1 frames (ATTENDANCE_FRAME_PLAIN_VERSION) carried
+// the events in clear, with no nonce or tag. Anyone on the serial line could forge one, so
+// they are only decoded when the caller asks for them, to read old captures.
+//
+// Event layout (ATTENDANCE_EVENT_BYTES):
+//   time        (4)      EpochTime, seconds since 2000-01-01 00:00:00
+//   member      (2)      member number in the member table
+//   kind        (1)      ATTENDANCE_ENTRY or ATTENDANCE_EXIT
+//   temperature (2)      signed, hundredths of a degree C, ATTENDANCE_NO_TEMPERATURE if unknown
+//   humidity    (1)      percent, ATTENDANCE_NO_HUMIDITY if unknown
+
+#include <crc.hpp>
+#include <aes_gcm.hpp>
+
+#define ATTENDANCE_SYNC_0 0xA5
+#define ATTENDANCE_SYNC_1 0x5A
+#define ATTENDANCE_FRAME_VERSION 2
+#define ATTENDANCE_FRAME_PLAIN_VERSION 1
+#define ATTENDANCE_FRAME_MAX_EVENTS 32
+#define ATTENDANCE_EVENT_BYTES 10
+#define ATTENDANCE_HEADER_BYTES 6
+#define ATTENDANCE_AAD_BYTES (ATTENDANCE_HEADER_BYTES - 2 + AES_GCM_NONCE_BYTES) // Version to nonce
+#define ATTENDANCE_CRC_BYTES 4
+#define ATTENDANCE_FRAME_MAX_BYTES                                                                                \
+    (ATTENDANCE_HEADER_BYTES + AES_GCM_NONCE_BYTES + ATTENDANCE_FRAME_MAX_EVENTS * ATTENDANCE_EVENT_BYTES + \
+     AES_GCM_TAG_BYTES + ATTENDANCE_CRC_BYTES)
+
+// Key the frames are sealed with, as 32 hex digits. This one is for development only:
+// build the firmware with -DATTENDANCE_KEY_HEX='"..."' and give the decoder the same key.
+// Firmware builds stop on the development key unless ATTENDANCE_ALLOW_DEVELOPMENT_KEY is
+// defined, for bench boards (see crypto_utils.cpp).
+#ifndef ATTENDANCE_KEY_HEX
+#define ATTENDANCE_KEY_HEX "000102030405060708090A0B0C0D0E0F"
+#define ATTENDANCE_DEVELOPMENT_KEY
+#endif
+
+#define ATTENDANCE_ENTRY 1
+#define ATTENDANCE_EXIT 2
+
+#define ATTENDANCE_NO_TEMPERATURE INT16_MIN
+#define ATTENDANCE_NO_HUMIDITY 0xFF
+
+// One attendance event as kept in the device's ring buffer
+struct AttendanceEvent
+{
+    uint32_t time;       // EpochTime
+    uint16_t member;     // Member number
+    uint8_t kind;        // ATTENDANCE_ENTRY / ATTENDANCE_EXIT
+    uint8_t humidity;    // Percent, or ATTENDANCE_NO_HUMIDITY
+    int16_t temperature; // Hundredths of a degree C, or ATTENDANCE_NO_TEMPERATURE
+};
+
+inline void attendancePut16(uint8_t *out, uint16_t value)
+{
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+}
+
+inline void attendancePut32(uint8_t *out, uint32_t value)
+{
+    attendancePut16(out, value & 0xFFFF);
+    attendancePut16(out + 2, value >> 16);
+}
+
+inline uint16_t attendanceGet16(const uint8_t *in)
+{
+    return in[0] | (in[1] << 8);
+}
+
+inline uint32_t attendanceGet32(const uint8_t *in)
+{
+    return attendanceGet16(in) | ((uint32_t)attendanceGet16(in + 2) << 16);
+}
+
+// AES-GCM over a batch in place: seal encrypts and writes the tag, open checks the tag and
+// decrypts. Both return false on failure.
+typedef bool (*AttendanceSeal)(const uint8_t *nonce, const uint8_t *aad, size_t aadLength, uint8_t *data,
+                               size_t length, uint8_t *tag);
+typedef bool (*AttendanceOpen)(const uint8_t *nonce, const uint8_t *aad, size_t aadLength, uint8_t *data,
+                               size_t length, const uint8_t *tag);
+
+// Function to encode `count` events (at most ATTENDANCE_FRAME_MAX_EVENTS) into `out`,
+// which must hold ATTENDANCE_FRAME_MAX_BYTES, sealing them with `seal` under `nonce`.
+// Returns the frame length in bytes, or 0 if sealing failed.
+inline size_t encodeAttendanceFrame(const AttendanceEvent *events, uint8_t count, uint16_t sequence,
+                                    const uint8_t *nonce, AttendanceSeal seal, uint8_t *out)
+{
+    out[0] = ATTENDANCE_SYNC_0;
+    out[1] = ATTENDANCE_SYNC_1;
+    out[2] = ATTENDANCE_FRAME_VERSION;
+    out[3] = count;
+    attendancePut16(out + 4, sequence);
+    memcpy(out + ATTENDANCE_HEADER_BYTES, nonce, AES_GCM_NONCE_BYTES);
+
+    uint8_t *payload = out + ATTENDANCE_HEADER_BYTES + AES_GCM_NONCE_BYTES;
+    uint8_t *p = payload;
+    for (uint8_t i = 0; i < count; i++, p += ATTENDANCE_EVENT_BYTES)
+    {
+        attendancePut32(p, events[i].time);
+        attendancePut16(p + 4, events[i].member);
+        p[6] = events[i].kind;
+        attendancePut16(p + 7, (uint16_t)events[i].temperature);
+        p[9] = events[i].humidity;
+    }
+
+    if (!seal(nonce, out + 2, ATTENDANCE_AAD_BYTES, payload, p - payload, p))
+    {
+        return 0;
+    }
+    p += AES_GCM_TAG_BYTES;
+    attendancePut32(p, crc32(out + 2, p - (out + 2)));
+    return p + ATTENDANCE_CRC_BYTES - out;
+}
+
+// Function to size a frame from its header bytes (at least ATTENDANCE_HEADER_BYTES).
+// Returns 0 if the header cannot start a valid frame.
+inline size_t attendanceFrameLength(const uint8_t *header)
+{
+    if (header[0] != ATTENDANCE_SYNC_0 || header[1] != ATTENDANCE_SYNC_1 ||
+        (header[2] != ATTENDANCE_FRAME_VERSION && header[2] != ATTENDANCE_FRAME_PLAIN_VERSION) || header[3] == 0 ||
+        header[3] > ATTENDANCE_FRAME_MAX_EVENTS)
+    {
+        return 0;
+    }
+    size_t sealing = header[2] == ATTENDANCE_FRAME_VERSION ? AES_GCM_NONCE_BYTES + AES_GCM_TAG_BYTES : 0;
+    return ATTENDANCE_HEADER_BYTES + sealing + header[3] * ATTENDANCE_EVENT_BYTES + ATTENDANCE_CRC_BYTES;
+}
+
+// Function to decode a complete frame of attendanceFrameLength() bytes, opening sealed
+// frames with `open`. Unauthenticated version 1 frames are refused unless `acceptPlain`.
+// Returns the number of events written to `events`, or 0 if the frame is refused or the
+// CRC or the tag does not match.
+inline uint8_t decodeAttendanceFrame(const uint8_t *frame, size_t length, AttendanceEvent *events, uint16_t &sequence,
+                                     AttendanceOpen open, bool acceptPlain = false)
+{
+    if (length < ATTENDANCE_HEADER_BYTES || attendanceFrameLength(frame) != length ||
+        (frame[2] == ATTENDANCE_FRAME_PLAIN_VERSION && !acceptPlain))
+    {
+        return 0;
+    }
+
+    const uint8_t *crcField = frame + length - ATTENDANCE_CRC_BYTES;
+    if (attendanceGet32(crcField) != crc32(frame + 2, crcField - (frame + 2)))
+    {
+        return 0;
+    }
+
+    uint8_t count = frame[3];
+    size_t payloadLength = count * ATTENDANCE_EVENT_BYTES;
+    uint8_t payload[ATTENDANCE_FRAME_MAX_EVENTS * ATTENDANCE_EVENT_BYTES];
+    if (frame[2] == ATTENDANCE_FRAME_VERSION)
+    {
+        const uint8_t *nonce = frame + ATTENDANCE_HEADER_BYTES;
+        memcpy(payload, nonce + AES_GCM_NONCE_BYTES, payloadLength);
+        const uint8_t *tag = nonce + AES_GCM_NONCE_BYTES + payloadLength;
+        if (!open(nonce, frame + 2, ATTENDANCE_AAD_BYTES, payload, payloadLength, tag))
+        {
+            return 0;
+        }
+    }
+    else
+    {
+        memcpy(payload, frame + ATTENDANCE_HEADER_BYTES, payloadLength);
+    }
+
+    sequence = attendanceGet16(frame + 4);
+    const uint8_t *p = payload;
+    for (uint8_t i = 0; i < count; i++, p += ATTENDANCE_EVENT_BYTES)
+    {
+        events[i].time = attendanceGet32(p);
+        events[i].member = attendanceGet16(p + 4);
+        events[i].kind = p[6];
+        events[i].temperature = (int16_t)attendanceGet16(p + 7);
+        events[i].humidity = p[9];
+    }
+    return count;
+}
+
+#endif // ATTENDANCE_FRAME_HPP
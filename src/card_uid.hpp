@@ -0,0 +1,121 @@
+#ifndef CARD_UID_HPP
+#define CARD_UID_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Maximum UID length of an ISO 14443 card (single, double or triple size)
+#define UID_MAX_BYTES 10
+
+// Size of a buffer able to hold any UID as a hex string, including the terminator
+#define UID_HEX_SIZE (UID_MAX_BYTES * 2 + 1)
+
+// Card UID stored as raw bytes plus a length, the way the reader reports it.
+// It is a plain value type (11 bytes, no heap), converted to hex only for display.
+struct CardUid
+{
+    uint8_t bytes[UID_MAX_BYTES];
+    uint8_t size;
+
+    bool operator==(const CardUid &other) const
+    {
+        return size == other.size && memcmp(bytes, other.bytes, size) == 0;
+    }
+
+    bool operator!=(const CardUid &other) const { return !(*this == other); }
+};
+
+// Function to hash a UID (FNV-1a over its bytes), for hash tables keyed by card
+inline uint32_t cardUidHash(const CardUid &uid)
+{
+    uint32_t h = 2166136261u;
+    for (uint8_t i = 0; i < uid.size; i++)
+    {
+        h = (h ^ uid.bytes[i]) * 16777619u;
+    }
+    return h;
+}
+
+// Function to convert one hex digit to its value (0xFF for a non-hex character)
+constexpr uint8_t uidHexDigit(char c)
+{
+    return (c >= '0' && c <= '9')   ? c - '0'
+           : (c >= 'A' && c <= 'F') ? c - 'A' + 10
+           : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+                                    : 0xFF;
+}
+
+// Deliberately neither constexpr nor defined: a UID literal with a non-hex character
+// reaches it, which fails to compile in a constant expression and to link anywhere else
+uint8_t invalidHexDigitInUidLiteral();
+
+// Function to convert one hex digit of a UID literal to its value
+constexpr uint8_t uidLiteralDigit(char c)
+{
+    return uidHexDigit(c) != 0xFF ? uidHexDigit(c) : invalidHexDigitInUidLiteral();
+}
+
+// Function to read byte i of a hex string of the given length, 0 past its end
+constexpr uint8_t uidHexByte(const char *hex, size_t length, size_t i)
+{
+    return i * 2 + 1 < length ? (uint8_t)((uidLiteralDigit(hex[i * 2]) << 4) | uidLiteralDigit(hex[i * 2 + 1])) : 0;
+}
+
+// Function to build a UID from a hex string literal at compile time,
+// e.g. constexpr CardUid admin = cardUidFromHex("53F7CA0E");
+template <size_t N>
+constexpr CardUid cardUidFromHex(const char (&hex)[N])
+{
+    static_assert(N > 1 && (N - 1) % 2 == 0 && (N - 1) / 2 <= UID_MAX_BYTES, "UID literal must be 2 to 20 hex digits");
+    return CardUid{{uidHexByte(hex, N - 1, 0), uidHexByte(hex, N - 1, 1), uidHexByte(hex, N - 1, 2),
+                    uidHexByte(hex, N - 1, 3), uidHexByte(hex, N - 1, 4), uidHexByte(hex, N - 1, 5),
+                    uidHexByte(hex, N - 1, 6), uidHexByte(hex, N - 1, 7), uidHexByte(hex, N - 1, 8),
+                    uidHexByte(hex, N - 1, 9)},
+                   (uint8_t)((N - 1) / 2)};
+}
+
+// Function to parse a hex UID string at run time (console input, roster files...).
+// Reads up to `length` characters. Returns false if the text is not a valid UID.
+inline bool parseCardUid(const char *hex, size_t length, CardUid &uid)
+{
+    if (length == 0 || length % 2 != 0 || length / 2 > UID_MAX_BYTES)
+    {
+        return false;
+    }
+
+    uid.size = length / 2;
+    for (uint8_t i = 0; i < uid.size; i++)
+    {
+        uint8_t high = uidHexDigit(hex[i * 2]);
+        uint8_t low = uidHexDigit(hex[i * 2 + 1]);
+        if (high > 0x0F || low > 0x0F)
+        {
+            return false;
+        }
+        uid.bytes[i] = (high << 4) | low;
+    }
+    return true;
+}
+
+inline bool parseCardUid(const char *hex, CardUid &uid)
+{
+    return parseCardUid(hex, strlen(hex), uid);
+}
+
+// Function to write a UID as upper-case hex into `out` (at least UID_HEX_SIZE bytes).
+// Returns a pointer to `out` so it can be passed straight to print().
+inline char *formatCardUid(const CardUid &uid, char *out)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    uint8_t size = uid.size <= UID_MAX_BYTES ? uid.size : UID_MAX_BYTES;
+    for (uint8_t i = 0; i < size; i++)
+    {
+        out[i * 2] = digits[uid.bytes[i] >> 4];
+        out[i * 2 + 1] = digits[uid.bytes[i] & 0x0F];
+    }
+    out[size * 2] = '\0';
+    return out;
+}
+
+#endif // CARD_UID_HPP
@@ -0,0 +1,88 @@
+#include <utils.hpp>
+
+// Software clock.
+// Reading the DS1302 bit-bangs its three-wire bus and keeps the CPU busy for a few hundred
+// microseconds, so timestamps do not come from it directly. The RTC is read at boot and
+// then every CLOCK_RESYNC_MS; in between the time is the last RTC reading plus the
+// monotonic microsecond timer elapsed since, and reading it is a subtraction and a
+// division. A resync that finds the clock ahead of the RTC does not set it back: the
+// clock holds its last value until the RTC catches up, so timestamps never go backwards.
+// Only loop() uses the clock.
+
+static EpochTime syncedTime = 0; // RTC time at the last good sync
+static uint64_t syncedAtUs = 0;  // halMonotonicUs() at the last good sync
+static uint64_t checkedAtUs = 0; // halMonotonicUs() at the last RTC read, good or not
+static EpochTime heldTime = 0;   // The clock reads no earlier than this
+ClockStats clockStats = {0, 0, 0};
+
+// Function to return the current time: the last RTC reading advanced by the monotonic timer
+EpochTime clockNow()
+{
+    EpochTime now = syncedTime + (EpochTime)((halMonotonicUs() - syncedAtUs) / 1000000);
+    return now > heldTime ? now : heldTime;
+}
+
+// Function to return the current time as a date and time
+RtcDateTime clockDateTime()
+{
+    return RtcDateTime(clockNow());
+}
+
+// Function to re-read the RTC and take its time. If the RTC has lost the time it is set
+// from the software clock instead.
+static void syncClock()
+{
+    RtcDateTime rtc = readQuartzTime();
+    checkedAtUs = halMonotonicUs();
+    clockStats.syncs++;
+    if (!rtc.IsValid())
+    {
+        clockStats.invalid++;
+        Rtc.SetDateTime(clockDateTime());
+        return;
+    }
+
+    EpochTime now = clockNow();
+    EpochTime rtcTime = toEpochTime(rtc);
+    clockStats.lastOffset = (long)rtcTime - (long)now;
+    heldTime = now;
+    syncedTime = rtcTime;
+    syncedAtUs = checkedAtUs;
+}
+
+// Function to start the clock from the RTC, called once from setup(). The RTC is only set
+// (to the firmware's build time) if it does not hold a valid time, e.g. after its backup
+// battery ran out, so a reboot never moves the time back.
+void startClock()
+{
+    if (Rtc.GetIsWriteProtected())
+    {
+        Rtc.SetIsWriteProtected(false);
+    }
+    if (!Rtc.GetIsRunning())
+    {
+        Rtc.SetIsRunning(true);
+    }
+
+    RtcDateTime rtc = readQuartzTime();
+    if (!rtc.IsValid())
+    {
+        clockStats.invalid++;
+        setDateTime();
+        rtc = readQuartzTime();
+    }
+    syncedTime = toEpochTime(rtc);
+    syncedAtUs = halMonotonicUs();
+    checkedAtUs = syncedAtUs;
+    heldTime = syncedTime;
+}
+
+// Function to resync the clock from the RTC once CLOCK_RESYNC_MS have passed, called on
+// every loop() pass
+void updateClock()
+{
+    if (halMonotonicUs() - checkedAtUs >= CLOCK_RESYNC_MS * 1000ULL)
+    {
+        syncClock();
+    }
+}
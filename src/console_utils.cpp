@@ -0,0 +1,364 @@
+#include <utils.hpp>
+
+// Serial command console.
+// Commands are single text lines ("help" lists them). Bytes are collected into one fixed
+// line buffer and, once a line is complete, split into arguments in place by writing
+// terminators over the separators, so parsing allocates nothing; the last argument of a
+// command runs to the end of the line, which lets names contain spaces. Commands that list
+// members do not build their reply in memory: they leave a cursor behind that pollConsole()
+// advances a few lines per loop() pass while the serial TX buffer has room, so a long list
+// never stalls scanning. No new command is read until the listing ends.
+
+#define CONSOLE_LINE_MAX 64     // Longest command line, including the terminator
+#define CONSOLE_MAX_ARGS 3      // Command word plus up to two arguments
+#define CONSOLE_STREAM_LINES 4  // Listing lines written per loop() pass
+#define CONSOLE_REPLY_MAX 64    // Longest line a listing writes
+
+// Listing being streamed out
+enum consoleListing : uint8_t
+{
+    LISTING_NONE,
+    LISTING_MEMBERS, // Every member
+    LISTING_PRESENT  // Members currently inside
+};
+
+struct consoleStream
+{
+    consoleListing listing;
+    int next;  // Member index the listing resumes at
+    int lines; // Lines written so far
+};
+
+// A console command: handler gets the arguments after the command word
+struct consoleCommand
+{
+    const char *name;
+    const char *usage;
+    void (*run)(char **args, int count);
+};
+
+static char consoleLine[CONSOLE_LINE_MAX];
+static uint8_t consoleLength = 0;
+static bool consoleOverflow = false; // Current line outgrew the buffer and is being skipped
+static consoleStream stream = {LISTING_NONE, 0, 0};
+
+// Function to find a member from a UID argument, printing why if there is none
+static int memberFromArg(const char *arg)
+{
+    CardUid uid;
+    if (!parseCardUid(arg, strlen(arg), uid))
+    {
+        Serial.println("Bad UID, expected hex digits");
+        return -1;
+    }
+    int index = uidToIndex(uid);
+    if (index < 0)
+    {
+        Serial.println("Member not found");
+    }
+    return index;
+}
+
+// Function to write one listing line for a member
+static void printMemberLine(int index)
+{
+    char uidHex[UID_HEX_SIZE];
+    char line[CONSOLE_REPLY_MAX];
+    snprintf(line, sizeof(line), "%-20s %-3s %-6s %s", formatCardUid(memberUids[index], uidHex),
+             memberLogged(index) ? "in" : "out", memberHasAccess(index) ? "access" : "denied", details_db[index].name);
+    Serial.println(line);
+}
+
+static void startListing(consoleListing listing)
+{
+    stream.listing = listing;
+    stream.next = 0;
+    stream.lines = 0;
+}
+
+static void commandMembers(char **args, int count)
+{
+    startListing(LISTING_MEMBERS);
+}
+
+static void commandPresent(char **args, int count)
+{
+    startListing(LISTING_PRESENT);
+}
+
+static void commandMember(char **args, int count)
+{
+    int index = memberFromArg(args[0]);
+    if (index < 0)
+    {
+        return;
+    }
+
+    printMemberLine(index);
+    const memberDetails &details = details_db[index];
+    if (details.lastLogTime != 0)
+    {
+        char lastAccess[TIME_STRING_SIZE];
+        Serial.print("Last access ");
+        Serial.println(epochToString(details.lastLogTime, lastAccess, sizeof(lastAccess)));
+    }
+    printSessionStats(index, clockDateTime());
+}
+
+static void commandGrant(char **args, int count)
+{
+    CardUid uid;
+    if (!parseCardUid(args[0], strlen(args[0]), uid))
+    {
+        Serial.println("Bad UID, expected hex digits");
+        return;
+    }
+
+    bool enrolled;
+    int index = grantCardAccess(uid, count > 1 ? args[1] : NULL, enrolled);
+    if (index < 0)
+    {
+        Serial.println("Member list full");
+        return;
+    }
+    Serial.print(enrolled ? "Enrolled: " : "Access granted: ");
+    printMemberLine(index);
+}
+
+static void commandRevoke(char **args, int count)
+{
+    int index = memberFromArg(args[0]);
+    if (index < 0)
+    {
+        return;
+    }
+    setMemberAccess(index, false);
+    Serial.print("Access revoked: ");
+    printMemberLine(index);
+}
+
+static void commandStats(char **args, int count)
+{
+    char line[CONSOLE_REPLY_MAX];
+    snprintf(line, sizeof(line), "Members %d/%d, inside %d", uidCount, MAX_UIDS, occupancyCount);
+    Serial.println(line);
+    snprintf(line, sizeof(line), "Scans: %lu re-reads suppressed, %lu dropped", scansSuppressed.get(), scansDropped.get());
+    Serial.println(line);
+    for (int i = 0; i < readerCount; i++)
+    {
+        snprintf(line, sizeof(line), "Reader %s (pin %d): %lu polls, %lu cards", readerConfigs[i].name,
+                 readerConfigs[i].chipSelectPin, readerCounters[i].polls.get(), readerCounters[i].scans.get());
+        Serial.println(line);
+    }
+    snprintf(line, sizeof(line), "Denied: %lu (%lu from cache, %lu rate limited)", denialStats.denied,
+             denialStats.cached, denialStats.limited);
+    Serial.println(line);
+    snprintf(line, sizeof(line), "Dropped: %lu joystick events, %lu attendance events", joystickEventsDropped.get(),
+             attendanceDropped);
+    Serial.println(line);
+    snprintf(line, sizeof(line), "Clock: %lu RTC resyncs, %lu invalid, last offset %ld s", clockStats.syncs,
+             clockStats.invalid, clockStats.lastOffset);
+    Serial.println(line);
+    halHeapStats heap = halHeap();
+    snprintf(line, sizeof(line), "Heap: %lu free, largest block %lu", (unsigned long)heap.freeBytes,
+             (unsigned long)heap.largestFreeBlock);
+    Serial.println(line);
+    printClimateStats();
+}
+
+static void commandLatency(char **args, int count)
+{
+    printLatency();
+}
+
+static void commandCrypto(char **args, int count)
+{
+    printCryptoThroughput();
+}
+
+static void commandRoster(char **args, int count)
+{
+    startRosterSerial();
+}
+
+static void commandHelp(char **args, int count);
+
+static const consoleCommand commands[] = {
+    {"help", "", commandHelp},
+    {"members", "", commandMembers},
+    {"present", "", commandPresent},
+    {"member", "<uid>", commandMember},
+    {"grant", "<uid> [name]", commandGrant},
+    {"revoke", "<uid>", commandRevoke},
+    {"stats", "", commandStats},
+    {"latency", "", commandLatency},
+    {"crypto", "", commandCrypto},
+    {"roster", "(then the roster)", commandRoster},
+};
+
+#define CONSOLE_COMMANDS (sizeof(commands) / sizeof(commands[0]))
+
+static void commandHelp(char **args, int count)
+{
+    for (size_t i = 0; i < CONSOLE_COMMANDS; i++)
+    {
+        Serial.print(commands[i].name);
+        Serial.print(' ');
+        Serial.println(commands[i].usage);
+    }
+}
+
+// Function to split the line into arguments in place. The last argument takes the rest of
+// the line. Returns the number of arguments found.
+static int splitLine(char *line, char **args)
+{
+    int count = 0;
+    char *p = line;
+    while (count < CONSOLE_MAX_ARGS)
+    {
+        while (*p == ' ' || *p == '\t')
+        {
+            p++;
+        }
+        if (*p == '\0')
+        {
+            break;
+        }
+
+        args[count++] = p;
+        if (count == CONSOLE_MAX_ARGS)
+        {
+            break;
+        }
+        while (*p != '\0' && *p != ' ' && *p != '\t')
+        {
+            p++;
+        }
+        if (*p != '\0')
+        {
+            *p++ = '\0';
+        }
+    }
+
+    // Trim trailing blanks off the last argument
+    if (count > 0)
+    {
+        char *end = args[count - 1] + strlen(args[count - 1]);
+        while (end > args[count - 1] && (end[-1] == ' ' || end[-1] == '\t'))
+        {
+            *--end = '\0';
+        }
+    }
+    return count;
+}
+
+// Function to run one complete command line
+static void runLine(char *line)
+{
+    char *args[CONSOLE_MAX_ARGS];
+    int count = splitLine(line, args);
+    if (count == 0)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < CONSOLE_COMMANDS; i++)
+    {
+        const consoleCommand &command = commands[i];
+        if (strcmp(args[0], command.name) != 0)
+        {
+            continue;
+        }
+        // Commands whose usage starts with "<" need that argument
+        if (command.usage[0] == '<' && count < 2)
+        {
+            Serial.print("Usage: ");
+            Serial.print(command.name);
+            Serial.print(' ');
+            Serial.println(command.usage);
+            return;
+        }
+        command.run(args + 1, count - 1);
+        return;
+    }
+
+    Serial.print("Unknown command: ");
+    Serial.println(args[0]);
+}
+
+// Function to write the next few lines of the listing in progress, as far as the serial
+// TX buffer has room for them
+static void continueListing()
+{
+    int written = 0;
+    while (written < CONSOLE_STREAM_LINES && stream.next < uidCount)
+    {
+        if (Serial.availableForWrite() < CONSOLE_REPLY_MAX)
+        {
+            return; // Resume once the UART has drained
+        }
+        int index = stream.next++;
+        if (stream.listing == LISTING_PRESENT && !memberLogged(index))
+        {
+            continue;
+        }
+        printMemberLine(index);
+        stream.lines++;
+        written++;
+    }
+
+    if (stream.next >= uidCount)
+    {
+        Serial.print("end ");
+        Serial.println(stream.lines);
+        stream.listing = LISTING_NONE;
+    }
+}
+
+// Function to serve the serial console, called on every loop() pass
+void pollConsole()
+{
+    if (rosterImportActive())
+    {
+        pollRosterSerial(); // Serial belongs to the roster until it ends
+        return;
+    }
+    if (stream.listing != LISTING_NONE)
+    {
+        continueListing();
+        return;
+    }
+
+    while (Serial.available() > 0)
+    {
+        char c = Serial.read();
+        if (c != '\n' && c != '\r')
+        {
+            if (consoleLength < sizeof(consoleLine) - 1)
+            {
+                consoleLine[consoleLength++] = c;
+            }
+            else
+            {
+                consoleOverflow = true;
+            }
+            continue;
+        }
+
+        bool overflow = consoleOverflow;
+        consoleLine[consoleLength] = '\0';
+        consoleLength = 0;
+        consoleOverflow = false;
+        if (overflow)
+        {
+            Serial.println("Command too long");
+            continue;
+        }
+
+        runLine(consoleLine);
+        if (stream.listing != LISTING_NONE || rosterImportActive())
+        {
+            return; // The listing or roster has serial until it ends
+        }
+    }
+}
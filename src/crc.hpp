@@ -0,0 +1,25 @@
+#ifndef CRC_HPP
+#define CRC_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-32 (IEEE 802.3, reflected polynomial 0xEDB88320), computed bit by bit so it
+// needs no lookup table in flash. Pass the previous result to continue a running CRC,
+// starting from 0.
+inline uint32_t crc32(const void *data, size_t length, uint32_t crc = 0)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= bytes[i];
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+#endif // CRC_HPP
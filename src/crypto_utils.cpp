@@ -0,0 +1,204 @@
+#include <utils.hpp>
+#include <attendance_frame.hpp>
+
+// Batch encryption for exported records.
+// Records are sealed a whole batch per call with AES-128-GCM: one key setup, one counter
+// mode pass over the batch and one 16-byte tag, however many records the batch holds. On
+// the ESP32, and on hosts built with mbedTLS, the cipher is mbedTLS, which the ESP32
+// Arduino core routes to the chip's AES peripheral; other host builds use the portable
+// implementation in aes_gcm.hpp. Only loop() seals or opens.
+
+// The development key is published with the source, so frames sealed with it are not secret
+#if defined(ARDUINO) && defined(ATTENDANCE_DEVELOPMENT_KEY)
+#ifdef ATTENDANCE_ALLOW_DEVELOPMENT_KEY
+#warning "Attendance frames are sealed with the public development key"
+#else
+#error "ATTENDANCE_KEY_HEX is the public development key; build with -DATTENDANCE_KEY_HEX='\"<32 hex digits>\"'"
+#endif
+#endif
+
+#if defined(ARDUINO) || defined(BADGE_HAVE_MBEDTLS)
+#define CRYPTO_MBEDTLS 1
+#include <mbedtls/gcm.h>
+#else
+#define CRYPTO_MBEDTLS 0
+#endif
+
+#define CRYPTO_BENCH_BYTES 4096  // Batch sealed per round of the throughput check
+#define CRYPTO_BENCH_ROUNDS 64
+
+#if CRYPTO_MBEDTLS
+typedef mbedtls_gcm_context GcmContext;
+#else
+typedef AesGcm GcmContext;
+#endif
+
+static GcmContext gcm;      // Keyed with the export key
+static GcmContext benchGcm; // Keyed with a throwaway key for the throughput check
+static bool cryptoReady = false;
+
+// Function to load `key` into a context. Returns false if the backend rejects it.
+static bool setGcmKey(GcmContext &context, const uint8_t key[AES_KEY_BYTES])
+{
+#if CRYPTO_MBEDTLS
+    mbedtls_gcm_init(&context);
+    return mbedtls_gcm_setkey(&context, MBEDTLS_CIPHER_ID_AES, key, AES_KEY_BYTES * 8) == 0;
+#else
+    context.setKey(key);
+    return true;
+#endif
+}
+
+// Function to seal a batch in place with a keyed context
+static bool sealWith(GcmContext &context, const uint8_t *nonce, const uint8_t *aad, size_t aadLength, uint8_t *data,
+                     size_t length, uint8_t *tag)
+{
+#if CRYPTO_MBEDTLS
+    return mbedtls_gcm_crypt_and_tag(&context, MBEDTLS_GCM_ENCRYPT, length, nonce, AES_GCM_NONCE_BYTES, aad,
+                                     aadLength, data, data, AES_GCM_TAG_BYTES, tag) == 0;
+#else
+    context.seal(nonce, aad, aadLength, data, length, tag);
+    return true;
+#endif
+}
+
+// Function to check and decrypt a batch in place with a keyed context
+static bool openWith(GcmContext &context, const uint8_t *nonce, const uint8_t *aad, size_t aadLength, uint8_t *data,
+                     size_t length, const uint8_t *tag)
+{
+#if CRYPTO_MBEDTLS
+    return mbedtls_gcm_auth_decrypt(&context, length, nonce, AES_GCM_NONCE_BYTES, aad, aadLength, tag,
+                                    AES_GCM_TAG_BYTES, data, data) == 0;
+#else
+    return context.open(nonce, aad, aadLength, data, length, tag);
+#endif
+}
+
+// Function to drop the key from a context
+static void clearGcmKey(GcmContext &context)
+{
+#if CRYPTO_MBEDTLS
+    mbedtls_gcm_free(&context);
+#else
+    memset(&context, 0, sizeof(context));
+#endif
+}
+
+// Function to run the GCM known answers (aes_gcm.hpp) through the backend in use, so a
+// broken build or AES peripheral is caught before it seals anything. Returns true if all
+// of them pass.
+bool cryptoSelfTest()
+{
+    int failed = aesGcmKnownAnswers(
+        [](const uint8_t *key) {
+            clearGcmKey(benchGcm);
+            return setGcmKey(benchGcm, key);
+        },
+        [](const uint8_t *nonce, const uint8_t *aad, size_t aadLength, uint8_t *data, size_t length, uint8_t *tag) {
+            return sealWith(benchGcm, nonce, aad, aadLength, data, length, tag);
+        },
+        [](const uint8_t *nonce, const uint8_t *aad, size_t aadLength, uint8_t *data, size_t length,
+           const uint8_t *tag) { return openWith(benchGcm, nonce, aad, aadLength, data, length, tag); });
+    clearGcmKey(benchGcm);
+    return failed == 0;
+}
+
+// Function to load the export key, called once from setup()
+void startCrypto()
+{
+    if (!cryptoSelfTest())
+    {
+        Serial.println("Crypto: AES-GCM self-test failed, export disabled");
+        return;
+    }
+
+    uint8_t key[AES_KEY_BYTES];
+    if (!parseAesKey(ATTENDANCE_KEY_HEX, key))
+    {
+        Serial.println("Crypto: ATTENDANCE_KEY_HEX is not 32 hex digits, export disabled");
+        return;
+    }
+    cryptoReady = setGcmKey(gcm, key);
+    memset(key, 0, sizeof(key));
+}
+
+// Function to name the AES backend in use
+const char *cryptoBackend()
+{
+#if defined(ARDUINO)
+    return "mbedTLS, ESP32 AES peripheral";
+#elif CRYPTO_MBEDTLS
+    return "mbedTLS";
+#else
+    return "portable";
+#endif
+}
+
+// Function to encrypt a batch of records in place and compute its tag over the batch and
+// `aad` (left in clear). Returns false if no key is loaded.
+bool sealRecords(const uint8_t *nonce, const uint8_t *aad, size_t aadLength, uint8_t *data, size_t length,
+                 uint8_t *tag)
+{
+    if (!cryptoReady)
+    {
+        return false;
+    }
+    return sealWith(gcm, nonce, aad, aadLength, data, length, tag);
+}
+
+// Function to check a sealed batch against its tag and decrypt it in place. Returns false
+// if it does not match.
+bool openRecords(const uint8_t *nonce, const uint8_t *aad, size_t aadLength, uint8_t *data, size_t length,
+                 const uint8_t *tag)
+{
+    if (!cryptoReady)
+    {
+        return false;
+    }
+    return openWith(gcm, nonce, aad, aadLength, data, length, tag);
+}
+
+// Function to measure sealing throughput on serial. The rounds use counter nonces, so they
+// are sealed under a random key of their own that is dropped afterwards, never the export
+// key. The time is taken with micros(), so on the host, whose clock does not count CPU
+// work, only the simulator's bench can time it.
+void printCryptoThroughput()
+{
+    static uint8_t batch[CRYPTO_BENCH_BYTES];
+    uint8_t key[AES_KEY_BYTES];
+    uint8_t nonce[AES_GCM_NONCE_BYTES] = {0};
+    uint8_t tag[AES_GCM_TAG_BYTES];
+
+    Serial.print("Crypto (");
+    Serial.print(cryptoBackend());
+    Serial.print("): ");
+    halRandom(key, sizeof(key));
+    bool ready = setGcmKey(benchGcm, key);
+    memset(key, 0, sizeof(key));
+
+    uint32_t start = micros();
+    for (int round = 0; ready && round < CRYPTO_BENCH_ROUNDS; round++)
+    {
+        nonce[0] = round;
+        ready = sealWith(benchGcm, nonce, NULL, 0, batch, sizeof(batch), tag);
+    }
+    uint32_t elapsed = micros() - start;
+    clearGcmKey(benchGcm);
+    if (!ready)
+    {
+        Serial.println("backend failed");
+        return;
+    }
+
+    char line[64];
+    if (elapsed == 0)
+    {
+        snprintf(line, sizeof(line), "%d KiB sealed, too fast for the clock", CRYPTO_BENCH_ROUNDS * CRYPTO_BENCH_BYTES / 1024);
+    }
+    else
+    {
+        snprintf(line, sizeof(line), "%d KiB sealed in %lu us, %.2f MB/s", CRYPTO_BENCH_ROUNDS * CRYPTO_BENCH_BYTES / 1024,
+                 (unsigned long)elapsed, (double)CRYPTO_BENCH_ROUNDS * CRYPTO_BENCH_BYTES / elapsed);
+    }
+    Serial.println(line);
+}
@@ -0,0 +1,54 @@
+#ifndef DENIED_CARDS_HPP
+#define DENIED_CARDS_HPP
+
+#include <card_uid.hpp>
+
+// Negative cache of recently denied cards.
+// A direct-mapped hash set: each UID has exactly one slot, chosen by its hash, holding the
+// card last denied there and when. Checking a card is one hash and one UID compare, and
+// the whole set is SLOTS * 16 bytes. Two cards sharing a slot simply evict each other,
+// which only costs the evicted one a member lookup the next time. Not thread-safe: only
+// loop() uses it.
+template <int SLOTS>
+class DeniedCards
+{
+    static_assert(SLOTS > 0 && (SLOTS & (SLOTS - 1)) == 0, "DeniedCards slot count must be a power of two");
+
+public:
+    DeniedCards() { clear(); }
+
+    // Function to check whether `uid` was denied less than `windowMs` before `now`
+    bool contains(const CardUid &uid, unsigned long now, unsigned long windowMs) const
+    {
+        const entry &slot = entries[cardUidHash(uid) & (SLOTS - 1)];
+        return slot.uid.size > 0 && slot.uid == uid && now - slot.deniedAt < windowMs;
+    }
+
+    // Function to remember that `uid` was denied at `now` (milliseconds)
+    void add(const CardUid &uid, unsigned long now)
+    {
+        entry &slot = entries[cardUidHash(uid) & (SLOTS - 1)];
+        slot.uid = uid;
+        slot.deniedAt = now;
+    }
+
+    // Function to forget every denied card
+    void clear()
+    {
+        for (int i = 0; i < SLOTS; i++)
+        {
+            entries[i].uid.size = 0;
+        }
+    }
+
+private:
+    struct entry
+    {
+        CardUid uid;
+        unsigned long deniedAt;
+    };
+
+    entry entries[SLOTS];
+};
+
+#endif // DENIED_CARDS_HPP
@@ -0,0 +1,79 @@
+#include <utils.hpp>
+#include <attendance_frame.hpp>
+
+// Attendance event log.
+// Entries and exits are appended to a fixed ring buffer of compact binary events and
+// drained to the host collector as CRC-checked frames (see attendance_frame.hpp), one
+// frame per batch instead of one text line per event. Each frame's events are encrypted
+// together under a fresh random nonce. When the buffer is full the oldest event is
+// overwritten and counted as dropped.
+
+static AttendanceEvent attendanceLog[ATTENDANCE_LOG_CAPACITY];
+static uint16_t attendanceHead = 0;               // Next event to send
+static uint16_t attendanceCount = 0;              // Events waiting to be sent
+static uint16_t attendanceSequence = 0;           // Sequence number of the next frame
+static unsigned long attendanceOldestTime = 0;    // millis() when the oldest waiting event was logged
+static uint8_t attendanceFrame[ATTENDANCE_FRAME_MAX_BYTES];
+unsigned long attendanceDropped = 0;              // Events overwritten before they were sent
+
+// Function to append an event to the log
+void logAttendanceEvent(EpochTime time, int member, uint8_t kind, float temperature, float humidity)
+{
+    if (attendanceCount == ATTENDANCE_LOG_CAPACITY)
+    {
+        // Make room by dropping the oldest event
+        attendanceHead = (attendanceHead + 1) % ATTENDANCE_LOG_CAPACITY;
+        attendanceCount--;
+        attendanceDropped++;
+    }
+    if (attendanceCount == 0)
+    {
+        attendanceOldestTime = millis();
+    }
+
+    AttendanceEvent &event = attendanceLog[(attendanceHead + attendanceCount) % ATTENDANCE_LOG_CAPACITY];
+    event.time = time;
+    event.member = member;
+    event.kind = kind;
+    event.temperature = isnan(temperature) ? ATTENDANCE_NO_TEMPERATURE : (int16_t)lroundf(temperature * 100);
+    event.humidity = (isnan(humidity) || humidity < 0 || humidity > 100) ? ATTENDANCE_NO_HUMIDITY : (uint8_t)lroundf(humidity);
+    attendanceCount++;
+}
+
+// Function to send waiting events as one frame, called from loop().
+// A frame goes out once a full batch is waiting, once the oldest event has waited
+// ATTENDANCE_FLUSH_MS, or whenever `force` is set. At most one frame is sent per call
+// so a large backlog never holds up the loop.
+void flushAttendanceLog(bool force)
+{
+    if (attendanceCount == 0)
+    {
+        return;
+    }
+    if (!force && attendanceCount < ATTENDANCE_BATCH_EVENTS && millis() - attendanceOldestTime < ATTENDANCE_FLUSH_MS)
+    {
+        return;
+    }
+
+    // Copy the batch out of the ring so the frame encoder sees contiguous events
+    AttendanceEvent batch[ATTENDANCE_FRAME_MAX_EVENTS];
+    uint8_t count = min((int)attendanceCount, ATTENDANCE_FRAME_MAX_EVENTS);
+    for (uint8_t i = 0; i < count; i++)
+    {
+        batch[i] = attendanceLog[(attendanceHead + i) % ATTENDANCE_LOG_CAPACITY];
+    }
+
+    uint8_t nonce[AES_GCM_NONCE_BYTES];
+    halRandom(nonce, sizeof(nonce));
+    size_t length = encodeAttendanceFrame(batch, count, attendanceSequence, nonce, sealRecords, attendanceFrame);
+    if (length == 0)
+    {
+        return; // No key to seal with, keep the events
+    }
+    attendanceSequence++;
+    Serial.write(attendanceFrame, length);
+
+    attendanceHead = (attendanceHead + count) % ATTENDANCE_LOG_CAPACITY;
+    attendanceCount -= count;
+    attendanceOldestTime = millis(); // Whatever is left starts a new wait
+}
@@ -0,0 +1,94 @@
+#include <utils.hpp>
+
+// A feedback sequence is a short list of LCD screens (entry, exit, denied, admin)
+// that are shown one after the other. Instead of blocking with delay() between
+// screens, loop() calls updateFeedback() which switches screens once the current
+// one has been on display long enough, so the card reader keeps being polled.
+
+// One screen of a feedback sequence
+struct feedbackScreen
+{
+    char line[LCD_ROWS][LCD_COLS + 1]; // Text for each LCD row
+    unsigned long duration;            // How long the screen stays up (milliseconds)
+};
+
+static feedbackScreen feedbackScreens[MAX_FEEDBACK_SCREENS];
+static int feedbackCount = 0;             // Number of screens queued in the current sequence
+static int feedbackIndex = -1;            // Screen currently on display (-1 = no sequence running)
+static bool feedbackDrawn = false;        // Whether the current screen has been drawn yet
+static unsigned long feedbackShownAt = 0; // millis() when the current screen was drawn
+
+// Function to start a new feedback sequence.
+// Any sequence that is still running is dropped, so a new card always takes over the display.
+void startFeedback()
+{
+    feedbackCount = 0;
+    feedbackIndex = -1;
+}
+
+// Function to append a screen to the sequence being built.
+// Lines longer than the LCD width are truncated; extra screens beyond the capacity are ignored.
+void addFeedbackScreen(const char *line1, const char *line2, unsigned long duration)
+{
+    if (feedbackCount >= MAX_FEEDBACK_SCREENS)
+    {
+        return;
+    }
+
+    feedbackScreen &screen = feedbackScreens[feedbackCount++];
+    snprintf(screen.line[0], sizeof(screen.line[0]), "%s", line1 ? line1 : "");
+    snprintf(screen.line[1], sizeof(screen.line[1]), "%s", line2 ? line2 : "");
+    screen.duration = duration;
+
+    // The first screen goes up on the next update
+    if (feedbackIndex < 0)
+    {
+        feedbackIndex = 0;
+        feedbackDrawn = false;
+    }
+}
+
+// Function to draw the current feedback screen
+static void showFeedbackScreen()
+{
+    const feedbackScreen &screen = feedbackScreens[feedbackIndex];
+    lcd.clear();
+    lcd.print(screen.line[0]);
+    lcd.setCursor(0, 1);
+    lcd.print(screen.line[1]);
+    feedbackShownAt = millis();
+    feedbackDrawn = true;
+}
+
+// Function to advance the running feedback sequence without blocking.
+// Returns true while a sequence still owns the display.
+bool updateFeedback()
+{
+    if (feedbackIndex < 0)
+    {
+        return false;
+    }
+
+    // Draw the first screen of a freshly started sequence
+    if (!feedbackDrawn)
+    {
+        showFeedbackScreen();
+        return true;
+    }
+
+    // Move to the next screen once the current one has been shown long enough
+    if (millis() - feedbackShownAt >= feedbackScreens[feedbackIndex].duration)
+    {
+        feedbackIndex++;
+        if (feedbackIndex >= feedbackCount)
+        {
+            // Sequence finished, hand the display back to the idle/admin screens
+            feedbackIndex = -1;
+            feedbackCount = 0;
+            return false;
+        }
+        showFeedbackScreen();
+    }
+
+    return true;
+}
@@ -0,0 +1,101 @@
+#ifndef HAL_HPP
+#define HAL_HPP
+
+// Hardware abstraction layer.
+// The firmware drives its devices through their Arduino libraries (MFRC522,
+// LiquidCrystal_I2C, RtcDS1302, DHT) and the core calls (millis, analogRead, tone), and
+// those interfaces are the device boundary: the host simulator in sim/ compiles the same
+// sources against its own versions of these headers, backed by simulated devices and a
+// virtual clock. This header pulls in the device libraries and declares the platform
+// services that have no common library interface, implemented in hal_esp32.cpp for the
+// board and in sim/hal_sim.cpp for the host.
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <MFRC522.h>
+#include <LiquidCrystal_I2C.h>
+#include <Wire.h>
+#include <RtcDS1302.h>
+#include <ThreeWire.h>
+#include <Adafruit_Sensor.h>
+#include <DHT.h>
+
+// --- Flash file store: LittleFS on the device, a directory of ordinary files on the host ---
+
+#ifdef ARDUINO
+#include <FS.h>
+typedef fs::File halFile;
+#define HAL_FILE_READ "r"
+#define HAL_FILE_APPEND "a"
+#define HAL_FILE_CREATE "w"
+#else
+#include <stdio.h>
+typedef FILE *halFile;
+#define HAL_FILE_READ "rb"
+#define HAL_FILE_APPEND "ab"
+#define HAL_FILE_CREATE "wb"
+#endif
+
+bool halFsMount();
+halFile halFileOpen(const char *path, const char *mode);
+bool halFileIsOpen(halFile &file);
+bool halFileSeek(halFile &file, uint32_t offset);
+size_t halFileRead(halFile &file, void *data, size_t size);
+size_t halFileWrite(halFile &file, const void *data, size_t size);
+void halFileClose(halFile &file);
+bool halFileReplace(const char *from, const char *to); // Atomically move `from` over `to`
+
+// --- Background services ---
+
+// Function to run `step` over and over on its own task pinned to `core`, yielding for
+// a tick between calls. On the host the service is a simulated task with its own clock.
+void halStartService(const char *name, void (*step)(), uint8_t core);
+
+// --- Cycle counter ---
+
+// CPU clock cycles of the calling core, for timing short intervals without leaving it.
+// Wraps every 17.9 s at 240 MHz. On the host it follows the virtual clock, so it times the
+// modelled device I/O but not the firmware's own CPU work.
+#define HAL_CYCLES_PER_US 240
+uint32_t halCycleCount();
+
+// --- Monotonic time ---
+
+// Microseconds since boot from a 64-bit timer that never wraps or steps: esp_timer on the
+// device, the main core's virtual clock on the host.
+uint64_t halMonotonicUs();
+
+// --- Random numbers ---
+
+// Function to fill `data` with random bytes: the hardware RNG on the device, the kernel's
+// on the host. Good enough for nonces.
+void halRandom(void *data, size_t size);
+
+// --- Heap ---
+
+// Free heap bytes and the largest block one allocation could still get. When the largest
+// block falls well behind the free total the heap has fragmented. On the host the figures
+// are the C library allocator's: its free bytes and the biggest of its free chunks.
+struct halHeapStats
+{
+    uint32_t freeBytes;
+    uint32_t largestFreeBlock;
+};
+halHeapStats halHeap();
+
+// --- One-shot timers ---
+// Callbacks run outside loop(): in the esp_timer task on the device, between the virtual
+// clock's ticks on the host. They must not block.
+
+#ifdef ARDUINO
+#include <esp_timer.h>
+typedef esp_timer_handle_t halTimer;
+#else
+typedef int halTimer;
+#endif
+
+halTimer halTimerCreate(const char *name, void (*callback)());
+void halTimerArm(halTimer timer, uint32_t delayUs); // Fire once after `delayUs`, replacing any pending shot
+void halTimerCancel(halTimer timer);
+
+#endif // HAL_HPP
@@ -0,0 +1,89 @@
+#ifdef ARDUINO
+
+#include <hal.hpp>
+#include <LittleFS.h>
+#include <esp_heap_caps.h>
+
+// --- Flash file store ---
+
+bool halFsMount() { return LittleFS.begin(true); }
+halFile halFileOpen(const char *path, const char *mode) { return LittleFS.open(path, mode); }
+bool halFileIsOpen(halFile &file) { return (bool)file; }
+bool halFileSeek(halFile &file, uint32_t offset) { return file.seek(offset); }
+size_t halFileRead(halFile &file, void *data, size_t size) { return file.read((uint8_t *)data, size); }
+size_t halFileWrite(halFile &file, const void *data, size_t size) { return file.write((const uint8_t *)data, size); }
+void halFileClose(halFile &file) { file.close(); }
+
+// lfs_rename() replaces an existing `to` in the same metadata commit, so a power cut leaves
+// either the old file or the new one
+bool halFileReplace(const char *from, const char *to) { return LittleFS.rename(from, to); }
+
+// --- Background services ---
+
+#define HAL_SERVICE_STACK 4096
+#define HAL_SERVICE_PRIORITY 1
+
+static void serviceTask(void *step)
+{
+    for (;;)
+    {
+        ((void (*)())step)();
+        vTaskDelay(1); // Let the idle task run so the task watchdog stays fed
+    }
+}
+
+void halStartService(const char *name, void (*step)(), uint8_t core)
+{
+    xTaskCreatePinnedToCore(serviceTask, name, HAL_SERVICE_STACK, (void *)step, HAL_SERVICE_PRIORITY, NULL, core);
+}
+
+// --- Cycle counter ---
+
+uint32_t halCycleCount() { return ESP.getCycleCount(); }
+
+// --- Monotonic time ---
+
+uint64_t halMonotonicUs() { return esp_timer_get_time(); }
+
+// --- Random numbers ---
+
+void halRandom(void *data, size_t size) { esp_fill_random(data, size); }
+
+// --- Heap ---
+
+halHeapStats halHeap()
+{
+    halHeapStats stats = {heap_caps_get_free_size(MALLOC_CAP_8BIT), heap_caps_get_largest_free_block(MALLOC_CAP_8BIT)};
+    return stats;
+}
+
+// --- One-shot timers ---
+
+static void timerCallback(void *callback) { ((void (*)())callback)(); }
+
+halTimer halTimerCreate(const char *name, void (*callback)())
+{
+    esp_timer_create_args_t args = {};
+    args.callback = timerCallback;
+    args.arg = (void *)callback;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = name;
+    halTimer timer = NULL;
+    esp_timer_create(&args, &timer);
+    return timer;
+}
+
+void halTimerArm(halTimer timer, uint32_t delayUs)
+{
+    // The callback may re-arm the timer from the esp_timer task between the stop and the
+    // start, in which case the start is refused and has to be retried
+    esp_timer_stop(timer);
+    while (esp_timer_start_once(timer, delayUs) == ESP_ERR_INVALID_STATE)
+    {
+        esp_timer_stop(timer);
+    }
+}
+
+void halTimerCancel(halTimer timer) { esp_timer_stop(timer); }
+
+#endif // ARDUINO
@@ -0,0 +1,116 @@
+#include <utils.hpp>
+#include <spsc_queue.hpp>
+
+// Joystick driver.
+// Both axes are sampled every JOYSTICK_SAMPLE_MS from a timer, independent of how busy
+// loop() is. Each axis is smoothed and then run through a three-position switch with
+// hysteresis: it only counts as pushed past the configured joystickHigh/joystickLow and
+// only counts as released again joystickHysteresis back towards the centre, so a reading
+// hovering around a threshold cannot chatter. Every push becomes one discrete event in a
+// lock-free queue for the admin menu; holding left or right repeats the event every
+// JOYSTICK_REPEAT_MS.
+
+#define JOYSTICK_FILTER_WEIGHT 4 // Smoothing: each sample moves the filter 1/4 of the way
+
+// One axis: smoothed reading, switch position (-1, 0 or 1) and when it last fired
+struct joystickAxis
+{
+    uint8_t pin;
+    int filtered;
+    int8_t position;
+    unsigned long firedAt;
+};
+
+static SpscQueue<JoystickEvent, JOYSTICK_QUEUE_SIZE> joystickQueue;
+static halTimer joystickTimer;
+static joystickAxis axisX = {JOYSTICK_URY_PIN, -1, 0, 0}; // Left/right
+static joystickAxis axisY = {JOYSTICK_URX_PIN, -1, 0, 0}; // Down (select) / up (back)
+SharedCounter joystickEventsDropped; // Events lost because the menu fell behind
+
+// Function to sample one axis and return its switch position after hysteresis
+static int8_t sampleAxis(joystickAxis &axis)
+{
+    int raw = analogRead(axis.pin);
+    if (axis.filtered < 0)
+    {
+        axis.filtered = raw; // First sample
+    }
+    axis.filtered += (raw - axis.filtered) / JOYSTICK_FILTER_WEIGHT;
+
+    int8_t position = axis.position;
+    if (position > 0 && axis.filtered < BadgeScanner::joystickHigh - BadgeScanner::joystickHysteresis)
+    {
+        position = 0;
+    }
+    else if (position < 0 && axis.filtered > BadgeScanner::joystickLow + BadgeScanner::joystickHysteresis)
+    {
+        position = 0;
+    }
+
+    if (position == 0 && axis.filtered > BadgeScanner::joystickHigh)
+    {
+        position = 1;
+    }
+    else if (position == 0 && axis.filtered < BadgeScanner::joystickLow)
+    {
+        position = -1;
+    }
+    return position;
+}
+
+static void emit(JoystickEvent event)
+{
+    if (!joystickQueue.push(event))
+    {
+        joystickEventsDropped.increment();
+    }
+}
+
+// Function to take one sample of both axes and queue the events it produces
+static void sampleJoystick()
+{
+    unsigned long now = millis();
+
+    int8_t x = sampleAxis(axisX);
+    if (x != axisX.position || (x != 0 && now - axisX.firedAt >= JOYSTICK_REPEAT_MS))
+    {
+        if (x != 0)
+        {
+            emit(x < 0 ? JOYSTICK_LEFT : JOYSTICK_RIGHT);
+            axisX.firedAt = now;
+        }
+        axisX.position = x;
+    }
+
+    // Select and back fire once per push
+    int8_t y = sampleAxis(axisY);
+    if (y != axisY.position)
+    {
+        if (y != 0)
+        {
+            emit(y < 0 ? JOYSTICK_SELECT : JOYSTICK_BACK);
+        }
+        axisY.position = y;
+    }
+
+    halTimerArm(joystickTimer, JOYSTICK_SAMPLE_MS * 1000UL);
+}
+
+// Function to start sampling the joystick in the background, called once from setup()
+void startJoystick()
+{
+    joystickTimer = halTimerCreate("joystick", sampleJoystick);
+    halTimerArm(joystickTimer, 0);
+}
+
+// Function to take the oldest joystick event not yet handled. Returns false if there is none.
+bool nextJoystickEvent(JoystickEvent &event)
+{
+    return joystickQueue.pop(event);
+}
+
+// Function to drop joystick events nobody is waiting for
+void discardJoystickEvents()
+{
+    joystickQueue.clear();
+}
@@ -0,0 +1,69 @@
+#ifndef LATENCY_HPP
+#define LATENCY_HPP
+
+// Scan pipeline latency probes.
+// Each stage between a card answering the reader and the member seeing the result is
+// timed and folded into a fixed-bucket histogram: bucket 0 counts times under 1 us and
+// bucket i times from 2^(i-1) up to 2^i us. Stages that stay on one core are timed with
+// the cycle counter; the hand-over between the reader task and loop() and the end-to-end
+// times use micros(), which both cores share.
+//
+// Build with -DLATENCY_PROBES=0 to compile every probe out; the macros then expand to
+// nothing and no histogram memory is reserved.
+
+#include <hal.hpp>
+
+#ifndef LATENCY_PROBES
+#define LATENCY_PROBES 1
+#endif
+
+#define LATENCY_BUCKETS 24          // Up to 2^23 us (8.4 s), longer times land in the last bucket
+#define SCAN_GRANT_BUDGET_US 50000  // Budget from card detection to the grant feedback starting
+
+enum latencyStage : uint8_t
+{
+    LATENCY_DETECT,  // PICC_IsNewCardPresent that found a card
+    LATENCY_READ,    // PICC_ReadCardSerial
+    LATENCY_DECODE,  // convertUID and the re-read filter
+    LATENCY_QUEUE,   // Scan read to taken by loop()
+    LATENCY_LOOKUP,  // checkMemberAccess
+    LATENCY_GRANT,   // Card detected to the grant (or goodbye) feedback starting
+    LATENCY_CLOCK,   // Software clock read for the entry or exit
+    LATENCY_CLIMATE, // get_temperature_humidity
+    LATENCY_STORE,   // storeMember
+    LATENCY_LCD,     // LCD refresh that puts up the first screen
+    LATENCY_SCREEN,  // Card detected to that screen being on the LCD
+    LATENCY_STAGES
+};
+
+#if LATENCY_PROBES
+
+extern unsigned long scansOverBudget;
+
+void recordLatency(latencyStage stage, uint32_t us);
+
+// Function to record the time since `startUs` (micros()), clamped at zero so stamps taken
+// on different cores cannot underflow
+inline void recordLatencySince(latencyStage stage, uint32_t startUs)
+{
+    int32_t elapsed = (int32_t)((uint32_t)micros() - startUs);
+    recordLatency(stage, elapsed > 0 ? elapsed : 0);
+}
+
+#define LATENCY_STAMP(name) uint32_t name = micros()
+#define LATENCY_START(name) uint32_t name = halCycleCount()
+#define LATENCY_STOP(stage, name) recordLatency(stage, (halCycleCount() - (name)) / HAL_CYCLES_PER_US)
+#define LATENCY_SINCE(stage, startUs) recordLatencySince(stage, startUs)
+
+#else
+
+#define LATENCY_STAMP(name)
+#define LATENCY_START(name)
+#define LATENCY_STOP(stage, name)
+#define LATENCY_SINCE(stage, startUs)
+
+#endif
+
+void printLatency();
+
+#endif // LATENCY_HPP
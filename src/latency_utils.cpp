@@ -0,0 +1,106 @@
+#include <utils.hpp>
+
+// Latency histograms behind the probes in latency.hpp. Each stage is recorded from one
+// core only (the reader task or loop()), so the counters need no locking; printLatency()
+// may see a reader-side histogram mid-update, which at worst skews one sample.
+
+#if LATENCY_PROBES
+
+struct latencyHistogram
+{
+    uint32_t buckets[LATENCY_BUCKETS];
+    uint32_t count;
+    uint32_t maxUs;
+    uint64_t totalUs;
+};
+
+static latencyHistogram histograms[LATENCY_STAGES];
+unsigned long scansOverBudget = 0; // Grants slower than SCAN_GRANT_BUDGET_US
+
+static const char *const stageNames[LATENCY_STAGES] = {
+    "detect", "read", "decode", "queue", "lookup", "grant", "clock", "climate", "store", "lcd", "screen",
+};
+
+// Function to fold one measurement into its stage's histogram
+void recordLatency(latencyStage stage, uint32_t us)
+{
+    latencyHistogram &histogram = histograms[stage];
+    int bucket = us == 0 ? 0 : 32 - __builtin_clz(us);
+    histogram.buckets[bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1]++;
+    histogram.count++;
+    histogram.totalUs += us;
+    if (us > histogram.maxUs)
+    {
+        histogram.maxUs = us;
+    }
+
+    if (stage == LATENCY_GRANT && us > SCAN_GRANT_BUDGET_US)
+    {
+        scansOverBudget++;
+        Serial.print("Latency: scan to grant took ");
+        Serial.print(us);
+        Serial.print(" us, budget ");
+        Serial.println(SCAN_GRANT_BUDGET_US);
+    }
+}
+
+// Function to return the upper bound in us of the bucket holding the given percentile
+static uint32_t percentileBound(const latencyHistogram &histogram, uint32_t percent)
+{
+    uint32_t wanted = (histogram.count * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        seen += histogram.buckets[i];
+        if (seen >= wanted)
+        {
+            return 1UL << i;
+        }
+    }
+    return 1UL << (LATENCY_BUCKETS - 1);
+}
+
+// Function to print every stage's histogram on serial, one line per stage:
+// count, mean, max, the bucket bounds of the median and 99th percentile, then each
+// non-empty bucket as "<bound:count"
+void printLatency()
+{
+    char line[48];
+    Serial.println("Latency (us):");
+    for (int stage = 0; stage < LATENCY_STAGES; stage++)
+    {
+        const latencyHistogram &histogram = histograms[stage];
+        if (histogram.count == 0)
+        {
+            continue;
+        }
+        snprintf(line, sizeof(line), "  %-8s n=%lu mean %lu max %lu", stageNames[stage], (unsigned long)histogram.count,
+                 (unsigned long)(histogram.totalUs / histogram.count), (unsigned long)histogram.maxUs);
+        Serial.print(line);
+        snprintf(line, sizeof(line), " p50<%lu p99<%lu |", (unsigned long)percentileBound(histogram, 50),
+                 (unsigned long)percentileBound(histogram, 99));
+        Serial.print(line);
+        for (int i = 0; i < LATENCY_BUCKETS; i++)
+        {
+            if (histogram.buckets[i] > 0)
+            {
+                snprintf(line, sizeof(line), " <%lu:%lu", 1UL << i, (unsigned long)histogram.buckets[i]);
+                Serial.print(line);
+            }
+        }
+        Serial.println();
+    }
+    Serial.print("  over the ");
+    Serial.print(SCAN_GRANT_BUDGET_US);
+    Serial.print(" us grant budget: ");
+    Serial.println(scansOverBudget);
+}
+
+#else
+
+void printLatency()
+{
+    Serial.println("Latency probes are compiled out (LATENCY_PROBES=0)");
+}
+
+#endif
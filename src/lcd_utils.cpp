@@ -0,0 +1,159 @@
+#include <utils.hpp>
+
+// The display is an HD44780 in 4-bit mode behind a PCF8574 I2C expander. Each expander
+// byte drives the data nibble (P4-P7), RS (P0), EN (P2) and the backlight (P3); the
+// HD44780 latches a nibble on the falling edge of EN, so a nibble takes two expander
+// bytes (EN high, then EN low) and a full command or character four.
+#define LCD_RS 0x01
+#define LCD_EN 0x04
+#define LCD_BACKLIGHT_BIT 0x08
+#define LCD_SET_DDRAM_ADDR 0x80
+
+// Expander bytes per HD44780 byte, and the most HD44780 bytes that fit in one
+// transaction with the I2C driver's 128 byte buffer
+#define LCD_EXPANDER_BYTES 4
+#define LCD_BYTES_PER_TRANSFER 31
+
+static const uint8_t rowOffsets[] = {0x00, 0x40, 0x14, 0x54};
+
+ShadowLCD::ShadowLCD(LiquidCrystal_I2C &device, uint8_t address)
+    : device(device), address(address), cursorCol(0), cursorRow(0), deviceCol(-1), deviceRow(-1), pending(0),
+      bytesSent(0), transactions(0)
+{
+    memset(wanted, ' ', sizeof(wanted));
+    memset(shown, ' ', sizeof(shown));
+}
+
+// Function to initialize the display through the driver library and start from a blank screen
+void ShadowLCD::init()
+{
+    device.init();
+    device.clear();
+    memset(shown, ' ', sizeof(shown));
+    deviceCol = 0;
+    deviceRow = 0;
+}
+
+void ShadowLCD::backlight()
+{
+    device.backlight();
+}
+
+// Function to blank the shadow screen and move the cursor home. Nothing is sent yet.
+void ShadowLCD::clear()
+{
+    memset(wanted, ' ', sizeof(wanted));
+    cursorCol = 0;
+    cursorRow = 0;
+}
+
+void ShadowLCD::setCursor(uint8_t col, uint8_t row)
+{
+    cursorCol = col;
+    cursorRow = row < LCD_ROWS ? row : LCD_ROWS - 1;
+}
+
+// Function to put one character at the cursor. Text past the end of a row is dropped,
+// like on the real display where it would land in invisible DDRAM.
+size_t ShadowLCD::write(uint8_t c)
+{
+    if (cursorCol < LCD_COLS)
+    {
+        wanted[cursorRow][cursorCol] = c;
+    }
+    cursorCol++;
+    return 1;
+}
+
+void ShadowLCD::beginTransfer()
+{
+    Wire.beginTransmission(address);
+    bytesSent++; // Address byte
+    transactions++;
+    pending = 0;
+}
+
+// Function to queue one HD44780 byte (command or character) in the open transaction
+void ShadowLCD::sendByte(uint8_t value, bool isData)
+{
+    if (pending == LCD_BYTES_PER_TRANSFER)
+    {
+        endTransfer();
+        beginTransfer();
+    }
+
+    uint8_t control = LCD_BACKLIGHT_BIT | (isData ? LCD_RS : 0);
+    uint8_t nibbles[2] = {(uint8_t)(value & 0xF0), (uint8_t)(value << 4)};
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        Wire.write(nibbles[i] | control | LCD_EN);
+        Wire.write(nibbles[i] | control);
+    }
+    bytesSent += LCD_EXPANDER_BYTES;
+    pending++;
+}
+
+void ShadowLCD::endTransfer()
+{
+    Wire.endTransmission();
+}
+
+// Function to send cells first..last of a row, moving the display cursor only if needed
+void ShadowLCD::sendRun(uint8_t row, uint8_t first, uint8_t last)
+{
+    if (deviceRow != row || deviceCol != first)
+    {
+        sendByte(LCD_SET_DDRAM_ADDR | (rowOffsets[row] + first), false);
+    }
+    for (uint8_t col = first; col <= last; col++)
+    {
+        sendByte(wanted[row][col], true);
+        shown[row][col] = wanted[row][col];
+    }
+    deviceRow = row;
+    deviceCol = last + 1;
+}
+
+// Function to send every changed cell to the display.
+// Changed cells separated by a single unchanged cell are sent as one run, since resending
+// that cell costs the same as moving the cursor past it.
+void ShadowLCD::refresh()
+{
+    bool open = false;
+    for (uint8_t row = 0; row < LCD_ROWS; row++)
+    {
+        int first = -1;
+        int last = -1;
+        for (uint8_t col = 0; col <= LCD_COLS; col++)
+        {
+            bool changed = col < LCD_COLS && wanted[row][col] != shown[row][col];
+            if (changed)
+            {
+                if (first >= 0 && col - last > 2)
+                {
+                    // Gap too wide to bridge: send what we have and start a new run
+                    sendRun(row, first, last);
+                    first = -1;
+                }
+                if (first < 0)
+                {
+                    first = col;
+                    if (!open)
+                    {
+                        beginTransfer();
+                        open = true;
+                    }
+                }
+                last = col;
+            }
+            else if (col == LCD_COLS && first >= 0)
+            {
+                sendRun(row, first, last);
+            }
+        }
+    }
+    if (open)
+    {
+        endTransfer();
+    }
+}
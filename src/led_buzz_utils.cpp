@@ -1,153 +1,180 @@
-#include <utils.hpp>
-
-// Function to setup the LED control
-void setupLEDControl()
-{
-    // Setup LEDC channel
-    ledcSetup(0, 5000, 8);       // channel 0, 5 kHz frequency, 8-bit resolution
-    ledcAttachPin(RED_PIN, 0);   // Attach RED_PIN to LEDC channel 0
-    ledcSetup(1, 5000, 8);       // channel 1, 5 kHz frequency, 8-bit resolution
-    ledcAttachPin(GREEN_PIN, 1); // Attach GREEN_PIN to LEDC channel 1
-    ledcSetup(2, 5000, 8);       // channel 2, 5 kHz frequency, 8-bit resolution
-    ledcAttachPin(BLUE_PIN, 2);  // Attach BLUE_PIN to LEDC channel 2
-}
-
-// Function to turn off all LEDs
-void turnOffLEDs()
-{
-    analogWrite(RED_PIN, 0);
-    analogWrite(GREEN_PIN, 0);
-    analogWrite(BLUE_PIN, 0);
-}
-
-void turnOffLedsAndBuzzer()
-{
-    // Turn off all LEDs
-    turnOffLEDs();
-
-    // Turn off the buzzer
-    digitalWrite(BUZZER_PIN, HIGH);
-}
-
-void playMelody(int note, int duration, int delayP)
-{
-    tone(BUZZER_PIN, note, duration);
-    delay(delayP);
-}
-
-// Function to play the goodbye melody
-void goodbyeMelody()
-{
-    // Ensure buzzer and LEDs is off initially
-    turnOffLedsAndBuzzer();
-
-    // Turn the LED blue
-    analogWrite(BLUE_PIN, 255);
-
-    // Play the melody
-    playMelody(NOTE_G5, 200, 250);
-    playMelody(NOTE_E5, 200, 250);
-    playMelody(NOTE_C5, 200, 250);
-
-    turnOffLedsAndBuzzer();
-}
-
-void turnLedYellow()
-{
-    // Turn off all LEDs
-    turnOffLEDs();
-
-    // Turn the LED yellow
-    analogWrite(RED_PIN, 255);
-    analogWrite(GREEN_PIN, 100);
-}
-
-void turnLedWhite()
-{
-    // Turn off all LEDs
-    turnOffLEDs();
-
-    // Turn the LED white
-    analogWrite(RED_PIN, 215);
-    analogWrite(GREEN_PIN, 86);
-    analogWrite(BLUE_PIN, 155);
-}
-
-void updateReceived()
-{
-    // Turn off all LEDs
-    turnLedWhite();
-
-    // Play the melody differently
-    playMelody(NOTE_G5, 200, 250);
-    playMelody(NOTE_C5, 200, 250);
-    playMelody(NOTE_E5, 200, 250);
-    playMelody(NOTE_C5, 200, 250);
-    playMelody(NOTE_G5, 200, 250);
-
-    turnOffLedsAndBuzzer();
-}
-
-// Function to play the admin goodbye melody
-void adminGoodbyeMelody()
-{
-    // Turn the LED blue
-    turnOffLedsAndBuzzer();
-
-    // Turn the LED yellow
-    turnLedYellow();
-
-    // Play the melody
-    playMelody(NOTE_C5, 200, 250);
-    playMelody(NOTE_G5, 200, 250);
-    playMelody(NOTE_E5, 200, 250);
-
-    turnOffLedsAndBuzzer();
-}
-
-// Function to play the admin access melody
-void adminAccessMelody()
-{
-    // Turn off all LEDs
-    turnOffLedsAndBuzzer();
-
-    // Turn the LED yellow
-    turnLedYellow();
-
-    // Play the melody
-    playMelody(NOTE_G5, 250, 350);
-    playMelody(NOTE_E5, 250, 350);
-
-    // Stop leds and buzzer
-    turnOffLedsAndBuzzer();
-}
-
-// Function to play the access granted melody
-void accessGrantedMelody()
-{
-    // Ensure buzzer is off initially
-    turnOffLedsAndBuzzer();
-    analogWrite(GREEN_PIN, 255);
-
-    // Play the melody
-    playMelody(NOTE_G5, 250, 350);
-    playMelody(NOTE_E5, 250, 350);
-
-    turnOffLedsAndBuzzer();
-}
-
-// Function to play the access denied melody
-void accessDeniedMelody()
-{
-    // Turn the LED red
-    turnOffLedsAndBuzzer();
-
-    // Turn the LED red
-    analogWrite(RED_PIN, 255);
-
-    // Play the melody
-    playMelody(NOTE_G4, 150, 150);
-    playMelody(NOTE_C4, 150, 150);
-
-    turnOffLedsAndBuzzer();
-}
+#include <utils.hpp>
+#include <atomic>
+
+// The LED and buzzer feedback is played by a sequencer on a one-shot timer, so starting
+// a melody returns at once instead of stalling loop() until the last note. Each pattern
+// is a constant table of steps; the timer applies a step, re-arms itself for the step's
+// length and turns everything off after the last one. Starting a pattern while another
+// is playing replaces it from its first step.
+
+// One step of a pattern: LED colour, buzzer note (0 for silence) and timing
+struct feedbackStep
+{
+    uint16_t note;   // Tone frequency in Hz
+    uint16_t toneMs; // How long the tone sounds
+    uint16_t stepMs; // How long until the next step
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+};
+
+struct feedbackPattern
+{
+    const feedbackStep *steps;
+    uint8_t count;
+};
+
+// Function to wrap a step table in a pattern, counting its steps at compile time
+template <size_t N>
+constexpr feedbackPattern makePattern(const feedbackStep (&steps)[N])
+{
+    return feedbackPattern{steps, N};
+}
+
+// LED colours
+#define LED_GREEN 0, 255, 0
+#define LED_RED 255, 0, 0
+#define LED_BLUE 0, 0, 255
+#define LED_YELLOW 255, 100, 0
+#define LED_WHITE 215, 86, 155
+
+static constexpr feedbackStep goodbyeSteps[] = {
+    {NOTE_G5, 200, 250, LED_BLUE},
+    {NOTE_E5, 200, 250, LED_BLUE},
+    {NOTE_C5, 200, 250, LED_BLUE},
+};
+
+static constexpr feedbackStep updateReceivedSteps[] = {
+    {NOTE_G5, 200, 250, LED_WHITE},
+    {NOTE_C5, 200, 250, LED_WHITE},
+    {NOTE_E5, 200, 250, LED_WHITE},
+    {NOTE_C5, 200, 250, LED_WHITE},
+    {NOTE_G5, 200, 250, LED_WHITE},
+};
+
+static constexpr feedbackStep adminGoodbyeSteps[] = {
+    {NOTE_C5, 200, 250, LED_YELLOW},
+    {NOTE_G5, 200, 250, LED_YELLOW},
+    {NOTE_E5, 200, 250, LED_YELLOW},
+};
+
+static constexpr feedbackStep adminAccessSteps[] = {
+    {NOTE_G5, 250, 350, LED_YELLOW},
+    {NOTE_E5, 250, 350, LED_YELLOW},
+};
+
+static constexpr feedbackStep accessGrantedSteps[] = {
+    {NOTE_G5, 250, 350, LED_GREEN},
+    {NOTE_E5, 250, 350, LED_GREEN},
+};
+
+static constexpr feedbackStep accessDeniedSteps[] = {
+    {NOTE_G4, 150, 150, LED_RED},
+    {NOTE_C4, 150, 150, LED_RED},
+};
+
+static constexpr feedbackPattern goodbyePattern = makePattern(goodbyeSteps);
+static constexpr feedbackPattern updateReceivedPattern = makePattern(updateReceivedSteps);
+static constexpr feedbackPattern adminGoodbyePattern = makePattern(adminGoodbyeSteps);
+static constexpr feedbackPattern adminAccessPattern = makePattern(adminAccessSteps);
+static constexpr feedbackPattern accessGrantedPattern = makePattern(accessGrantedSteps);
+static constexpr feedbackPattern accessDeniedPattern = makePattern(accessDeniedSteps);
+
+// Sequencer state. Only the timer callback touches the playing pattern; loop() hands it
+// a new one through requestedPattern and fires the timer straight away.
+static halTimer sequencerTimer;
+static std::atomic<const feedbackPattern *> requestedPattern(nullptr);
+static const feedbackPattern *playingPattern = nullptr;
+static uint8_t playingStep = 0;
+
+// Function to play the next step of the current pattern, or switch to a requested one
+static void sequencerStep()
+{
+    const feedbackPattern *requested = requestedPattern.exchange(nullptr);
+    if (requested)
+    {
+        playingPattern = requested;
+        playingStep = 0;
+    }
+    if (!playingPattern)
+    {
+        return;
+    }
+
+    if (playingStep >= playingPattern->count)
+    {
+        turnOffLedsAndBuzzer();
+        playingPattern = nullptr;
+        return;
+    }
+
+    const feedbackStep &step = playingPattern->steps[playingStep++];
+    analogWrite(RED_PIN, step.red);
+    analogWrite(GREEN_PIN, step.green);
+    analogWrite(BLUE_PIN, step.blue);
+    if (step.note)
+    {
+        tone(BUZZER_PIN, step.note, step.toneMs);
+    }
+    else
+    {
+        noTone(BUZZER_PIN);
+    }
+    halTimerArm(sequencerTimer, step.stepMs * 1000UL);
+}
+
+// Function to start `pattern`, cutting off whatever is playing
+static void playPattern(const feedbackPattern &pattern)
+{
+    requestedPattern.store(&pattern);
+    halTimerArm(sequencerTimer, 0);
+}
+
+// Function to setup the LED control
+void setupLEDControl()
+{
+    // Setup LEDC channel
+    ledcSetup(0, 5000, 8);       // channel 0, 5 kHz frequency, 8-bit resolution
+    ledcAttachPin(RED_PIN, 0);   // Attach RED_PIN to LEDC channel 0
+    ledcSetup(1, 5000, 8);       // channel 1, 5 kHz frequency, 8-bit resolution
+    ledcAttachPin(GREEN_PIN, 1); // Attach GREEN_PIN to LEDC channel 1
+    ledcSetup(2, 5000, 8);       // channel 2, 5 kHz frequency, 8-bit resolution
+    ledcAttachPin(BLUE_PIN, 2);  // Attach BLUE_PIN to LEDC channel 2
+
+    sequencerTimer = halTimerCreate("feedback", sequencerStep);
+}
+
+// Function to turn off all LEDs
+void turnOffLEDs()
+{
+    analogWrite(RED_PIN, 0);
+    analogWrite(GREEN_PIN, 0);
+    analogWrite(BLUE_PIN, 0);
+}
+
+void turnOffLedsAndBuzzer()
+{
+    // Turn off all LEDs
+    turnOffLEDs();
+
+    // Turn off the buzzer
+    digitalWrite(BUZZER_PIN, HIGH);
+}
+
+// Function to play the goodbye melody
+void goodbyeMelody() { playPattern(goodbyePattern); }
+
+// Function to play the update received melody
+void updateReceived() { playPattern(updateReceivedPattern); }
+
+// Function to play the admin goodbye melody
+void adminGoodbyeMelody() { playPattern(adminGoodbyePattern); }
+
+// Function to play the admin access melody
+void adminAccessMelody() { playPattern(adminAccessPattern); }
+
+// Function to play the access granted melody
+void accessGrantedMelody() { playPattern(accessGrantedPattern); }
+
+// Function to play the access denied melody
+void accessDeniedMelody() { playPattern(accessDeniedPattern); }
@@ -1,432 +1,758 @@
-#include <utils.hpp>
-
-// Global variables for menu navigation and state
-bool detailMode = false;   // Indicates if detailed view mode is active (currently unused)
-bool adminFlag = false;    // Flag indicating if admin is logged in
-bool updateDisplay = true; // Flag to indicate when to update the LCD display
-int mainMenuIndex = 0;     // Tracks the current main menu selection index
-int menuLevel = 0;         // Current menu level (0 = main menu, 1 = member list, 2 = member details)
-
-// Static variables for internal state management
-static int detailIndex = 0;                 // Index used to cycle through member detail pages
-static unsigned long lastDebounceTime = 0;  // Timestamp for last joystick input processed
-const unsigned long debounceDelay = 300;    // Debounce delay for joystick button press (milliseconds)
-const unsigned long navigationDelay = 1000; // Delay for left/right navigation to prevent fast scrolling
-
-// --- Helper functions for menu navigation ---
-
-// Navigate one step left based on current menu level
-void navigateLeft()
-{
-  if (menuLevel == 0)
-  {
-    // Navigate left in main menu, wrap around if at first item
-    mainMenuIndex = (mainMenuIndex > 0) ? mainMenuIndex - 1 : 3;
-  }
-  else if (menuLevel == 1)
-  {
-    // Navigate left in member list, wrap around to last member if at first
-    currentMemberIndex = (currentMemberIndex > 0) ? currentMemberIndex - 1 : uidCount - 1;
-  }
-  else if (menuLevel == 2)
-  {
-    // Cycle left through member detail pages, wrap around if at first detail page
-    detailIndex = (detailIndex > 0) ? detailIndex - 1 : 4;
-  }
-  updateDisplay = true;        // Mark that LCD should be updated after navigation
-  lastDebounceTime = millis(); // Update debounce timer to prevent rapid input repeats
-}
-
-// Navigate one step right based on current menu level
-void navigateRight()
-{
-  if (menuLevel == 0)
-  {
-    // Navigate right in main menu, wrap around if at last item
-    mainMenuIndex = (mainMenuIndex < 3) ? mainMenuIndex + 1 : 0;
-  }
-  else if (menuLevel == 1)
-  {
-    // Navigate right in member list, wrap around to first member if at last
-    currentMemberIndex = (currentMemberIndex < uidCount - 1) ? currentMemberIndex + 1 : 0;
-  }
-  else if (menuLevel == 2)
-  {
-    // Cycle right through member detail pages, wrap around if at last detail page
-    detailIndex = (detailIndex < 4) ? detailIndex + 1 : 0;
-  }
-  updateDisplay = true;        // Mark that LCD should be updated after navigation
-  lastDebounceTime = millis(); // Update debounce timer
-}
-
-// Select or "enter" the current menu option or detail
-void selectMenuOption()
-{
-  if (menuLevel == 0)
-  {
-    // Main menu selection handling
-    switch (mainMenuIndex)
-    {
-    case 0:
-      menuLevel = 1; // Enter member list view
-      break;
-    case 1:
-      addCardAccess(); // Trigger adding card access procedure
-      break;
-    case 2:
-      removeCardAccess(); // Trigger removing card access procedure
-      break;
-    case 3:
-      showTotalNumber(); // Show total number of members
-      break;
-    }
-  }
-  else if (menuLevel == 1)
-  {
-    // From member list, enter detailed info view
-    menuLevel = 2;
-  }
-  updateDisplay = true;        // Mark that LCD should be updated after selection
-  lastDebounceTime = millis(); // Update debounce timer
-}
-
-// Go back or exit current menu level
-void goBack()
-{
-  if (menuLevel == 2)
-  {
-    // From member details back to member list
-    menuLevel = 1;
-  }
-  else if (menuLevel == 1)
-  {
-    // From member list back to main menu with a short message
-    lcd.clear();
-    lcd.print("Exiting...");
-    delay(1000);
-    menuLevel = 0;
-  }
-  updateDisplay = true;        // Mark that LCD should be updated after going back
-  lastDebounceTime = millis(); // Update debounce timer
-}
-
-// --- Function to update the LCD display based on current menu state ---
-
-void updateLCDMenu()
-{
-  if (menuLevel == 0)
-  {
-    // Display main menu options
-    lcd.clear();
-    switch (mainMenuIndex)
-    {
-    case 0:
-      lcd.print("See Members");
-      lcd.setCursor(3, 1);
-      lcd.print("--page 1--");
-      break;
-    case 1:
-      lcd.print("Add Access");
-      lcd.setCursor(3, 1);
-      lcd.print("--page 2--");
-      break;
-    case 2:
-      lcd.print("Remove Access");
-      lcd.setCursor(3, 1);
-      lcd.print("--page 3--");
-      break;
-    case 3:
-      lcd.print("Total Number");
-      lcd.setCursor(3, 1);
-      lcd.print("--page 4--");
-      break;
-    default:
-      lcd.print("Default");
-      break;
-    }
-  }
-  else if (uidCount == 0)
-  {
-    // No members registered
-    lcd.clear();
-    lcd.print("No Members");
-    menuLevel = 1;
-  }
-  else if (menuLevel == 1)
-  {
-    // Show selected member's name in member list
-    lcd.clear();
-    lcd.print(users_db[currentMemberIndex].name);
-    lcd.setCursor(3, 1);
-    lcd.print("--page ");
-    lcd.print(currentMemberIndex + 1);
-    lcd.print("--");
-  }
-  else if (menuLevel == 2)
-  {
-    // Show detailed info for selected member based on detailIndex page
-    lcd.clear();
-    switch (detailIndex)
-    {
-    case 0:
-      lcd.print("UID: ");
-      lcd.print(users_db[currentMemberIndex].uid);
-      break;
-    case 1:
-      lcd.print("Logged: ");
-      lcd.print(users_db[currentMemberIndex].logged ? "Yes" : "No");
-      break;
-    case 2:
-      lcd.print("Last access:");
-      lcd.setCursor(0, 1);
-      lcd.print(users_db[currentMemberIndex].lastLogTime);
-      break;
-    case 3:
-    {
-      lcd.print("Last time spent:");
-      lcd.setCursor(0, 1);
-      lcd.print(formatSpentTime(users_db[currentMemberIndex].lastTimeSpent));
-      break;
-    }
-    default:
-      lcd.print("Default");
-      break;
-    }
-  }
-  updateDisplay = false; // Reset flag after updating display
-}
-
-// --- Main function that handles admin menu interaction using joystick input ---
-
-void adminLogged()
-{
-  int joyX = analogRead(JOYSTICK_URY_PIN); // Read joystick X-axis (left/right)
-  int joyY = analogRead(JOYSTICK_URX_PIN); // Read joystick Y-axis (up/down)
-  unsigned long currentTime = millis();    // Current system time in ms
-
-  // Left navigation (with delay to prevent rapid changes)
-  if (joyX < LOWER_JOYSTICK_THRESHOLD && (currentTime - lastDebounceTime > navigationDelay))
-  {
-    navigateLeft();
-  }
-  // Right navigation (with delay)
-  else if (joyX > UPPER_JOYSTICK_THRESHOLD && (currentTime - lastDebounceTime > navigationDelay))
-  {
-    navigateRight();
-  }
-
-  // Select button pressed (joystick down)
-  if (joyY < LOWER_JOYSTICK_THRESHOLD && (currentTime - lastDebounceTime > debounceDelay))
-  {
-    selectMenuOption();
-  }
-  // Back button pressed (joystick up)
-  else if (joyY > UPPER_JOYSTICK_THRESHOLD && (currentTime - lastDebounceTime > debounceDelay))
-  {
-    goBack();
-  }
-
-  // Update LCD if flagged
-  if (updateDisplay)
-  {
-    updateLCDMenu();
-  }
-}
-
-// --- Setup function to initialize hardware and peripherals ---
-
-void setup()
-{
-  Serial.begin(115200); // Start serial communication for debugging
-
-  // Initialize communication buses and devices
-  Wire.begin(LCD_SDA_PIN, LCD_SCL_PIN); // I2C for LCD
-  SPI.begin();                          // SPI for RFID reader
-  mfrc522.PCD_Init();                   // Initialize RFID reader
-  Rtc.Begin();                          // Initialize RTC
-  lcd.init();                           // Initialize LCD
-  lcd.backlight();                      // Turn on LCD backlight
-
-  // Set pins as outputs for LEDs and buzzer
-  pinMode(GREEN_PIN, OUTPUT);
-  pinMode(RED_PIN, OUTPUT);
-  pinMode(BLUE_PIN, OUTPUT);
-  pinMode(BUZZER_PIN, OUTPUT);
-
-  setupLEDControl(); // Setup PWM channels for LEDs
-
-  digitalWrite(BUZZER_PIN, HIGH); // Turn buzzer off initially (assuming active low)
-  turnOffLEDs();                  // Turn off all LEDs initially
-
-  Serial.println("Approximate your card to the reader...");
-
-  setDateTime(); // Set RTC date/time based on compile time
-
-  dht.begin(); // Initialize temperature and humidity sensor
-
-  // Initialize joystick pins as inputs
-  pinMode(JOYSTICK_URX_PIN, INPUT);
-  pinMode(JOYSTICK_URY_PIN, INPUT);
-  pinMode(JOYSTICK_SW_PIN, INPUT);
-
-  Serial.println("Setting up members...");
-}
-
-// --- Helper functions for handling card processing ---
-
-// Called when admin card is scanned and admin is not logged in
-void processAdminCard()
-{
-  adminAccessMelody(); // Play admin access melody and turn on LEDs
-  Serial.println("Admin Access Granted");
-  lcd.clear();
-  lcd.print("Admin Access");
-  lcd.setCursor(0, 1);
-  lcd.print("Granted");
-  adminFlag = true; // Set admin flag to true
-  delay(2000);      // Pause so user can read the message
-}
-
-// Called when admin card is scanned and admin is currently logged in (exit admin mode)
-void processAdminExit()
-{
-  adminGoodbyeMelody(); // Play admin exit melody
-  Serial.println("Admin Exited");
-  lcd.clear();
-  lcd.print("Admin Exited");
-  adminFlag = false; // Reset admin flag
-  delay(2000);
-}
-
-// Called when a member enters (logs in)
-void processMemberEntry(int index)
-{
-  accessGrantedMelody(); // Play access granted melody
-  RtcDateTime now = Rtc.GetDateTime();
-  String nowString = timeToString(now);
-
-  float temperature = 0, humidity = 0;
-  get_temperature_humidity(temperature, humidity);
-
-  Serial.println(users_db[index].lastLogTime);
-  users_db[index].logged = true;                   // Mark member as logged in
-  users_db[index].lastLogTime = nowString;         // Record last access time as string
-  users_db[index].lastLogTimeInt = dateToInt(now); // Record last access time as int (seconds)
-
-  Serial.println("Access Granted");
-  lcd.clear();
-  lcd.print("Access Granted");
-  lcd.setCursor(0, 1);
-  lcd.print(nowString);
-  delay(1000);
-
-  lcd.clear();
-  lcd.print("Welcome");
-  Serial.println("Welcome");
-  lcd.setCursor(0, 1);
-  lcd.print(users_db[index].name);
-  Serial.println(users_db[index].name);
-  delay(1500);
-
-  lcd.clear();
-  lcd.print("Temp: ");
-  lcd.print(temperature);
-  lcd.print("C");
-  lcd.setCursor(0, 1);
-  lcd.print("Humidity: ");
-  lcd.print(humidity);
-  lcd.print("%");
-  delay(1500);
-}
-
-// Called when a member exits (logs out)
-void processMemberExit(int index)
-{
-  goodbyeMelody(); // Play goodbye melody
-  RtcDateTime now = Rtc.GetDateTime();
-  String nowString = timeToString(now);
-  Serial.println(nowString);
-
-  users_db[index].logged = false; // Mark member as logged out
-
-  float temperature = 0, humidity = 0;
-  get_temperature_humidity(temperature, humidity);
-
-  Serial.println("Logging out...");
-  lcd.clear();
-  lcd.print("Left at ");
-  lcd.setCursor(0, 1);
-  lcd.print(nowString);
-  delay(2000);
-  displayExitTime(now, index); // Display the time spent information
-}
-
-// --- Main program loop ---
-
-void loop()
-{
-  // Read card regardless of admin mode to allow toggling admin mode
-  if (mfrc522.PICC_IsNewCardPresent() && mfrc522.PICC_ReadCardSerial())
-  {
-    String readUID = convertUID(mfrc522);
-    Serial.print("Card UID:");
-    Serial.println(readUID);
-
-    if (readUID == ADMIN_UID)
-    {
-      // Toggle admin mode on/off when admin card is scanned
-      if (!adminFlag)
-      {
-        processAdminCard();
-      }
-      else
-      {
-        processAdminExit();
-      }
-      turnOffLEDs(); // Ensure LEDs off after admin card scan
-      // Do NOT return here to allow processing below
-    }
-    else if (adminFlag)
-    {
-      // If in admin mode, ignore member card scans but keep menu active
-      turnOffLEDs();
-      // No return, so menu keeps updating below
-    }
-    else
-    {
-      // If not in admin mode, check member access and log entry/exit
-      if (isAuthorizedUID(readUID))
-      {
-        int index = uidToIndex(readUID);
-        if (!users_db[index].logged)
-        {
-          processMemberEntry(index);
-        }
-        else
-        {
-          processMemberExit(index);
-        }
-      }
-      else
-      {
-        // Unauthorized access attempt feedback
-        accessDeniedMelody();
-        Serial.println("Access Denied");
-        lcd.clear();
-        lcd.print("Access Denied");
-      }
-      turnOffLEDs();
-      // No return here to allow idle display below if needed
-    }
-  }
-
-  // If admin mode is active, handle admin menu interaction
-  if (adminFlag)
-  {
-    adminLogged();
-    return; // Skip idle display when in admin mode
-  }
-
-  // If not admin, show idle message on LCD
-  printIdle();
-}
+#include <utils.hpp>
+#include <attendance_frame.hpp>
+
+// Global variables for menu navigation and state
+bool detailMode = false;   // Indicates if detailed view mode is active (currently unused)
+bool adminFlag = false;    // Flag indicating if admin is logged in
+bool updateDisplay = true; // Flag to indicate when to update the LCD display
+int mainMenuIndex = 0;     // Tracks the current main menu selection index
+int menuLevel = 0;         // Current menu level (0 = main menu, 1 = member list, 2 = member details, 3 = occupancy,
+                           // 4 = add access, 5 = remove access, 6 = total number)
+
+// Static variables for internal state management
+static int detailIndex = 0;                 // Index used to cycle through member detail pages
+static int occupancyHourIndex = 0;          // Hour shown on the occupancy page
+#if LATENCY_PROBES
+static uint32_t scanDetectedAtUs = 0; // micros() when the card being handled was detected
+static bool grantScreenPending = false; // Whether the next LCD refresh shows a grant's first screen
+#endif
+
+// --- Helper functions for menu navigation ---
+
+// Navigate one step left based on current menu level
+void navigateLeft()
+{
+  if (menuLevel == 0)
+  {
+    // Navigate left in main menu, wrap around if at first item
+    mainMenuIndex = (mainMenuIndex > 0) ? mainMenuIndex - 1 : BadgeScanner::mainMenuPages - 1;
+  }
+  else if (menuLevel == 1)
+  {
+    // Navigate left in member list, wrap around to last member if at first
+    currentMemberIndex = (currentMemberIndex > 0) ? currentMemberIndex - 1 : uidCount - 1;
+  }
+  else if (menuLevel == 2)
+  {
+    // Cycle left through member detail pages, wrap around if at first detail page
+    detailIndex = (detailIndex > 0) ? detailIndex - 1 : BadgeScanner::detailPages - 1;
+  }
+  else if (menuLevel == 3)
+  {
+    // Step back one hour in the occupancy histogram, wrap around at midnight
+    occupancyHourIndex = (occupancyHourIndex > 0) ? occupancyHourIndex - 1 : BadgeScanner::occupancyPages - 1;
+  }
+  updateDisplay = true; // Mark that LCD should be updated after navigation
+}
+
+// Navigate one step right based on current menu level
+void navigateRight()
+{
+  if (menuLevel == 0)
+  {
+    // Navigate right in main menu, wrap around if at last item
+    mainMenuIndex = (mainMenuIndex < BadgeScanner::mainMenuPages - 1) ? mainMenuIndex + 1 : 0;
+  }
+  else if (menuLevel == 1)
+  {
+    // Navigate right in member list, wrap around to first member if at last
+    currentMemberIndex = (currentMemberIndex < uidCount - 1) ? currentMemberIndex + 1 : 0;
+  }
+  else if (menuLevel == 2)
+  {
+    // Cycle right through member detail pages, wrap around if at last detail page
+    detailIndex = (detailIndex < BadgeScanner::detailPages - 1) ? detailIndex + 1 : 0;
+  }
+  else if (menuLevel == 3)
+  {
+    // Step forward one hour in the occupancy histogram
+    occupancyHourIndex = (occupancyHourIndex < BadgeScanner::occupancyPages - 1) ? occupancyHourIndex + 1 : 0;
+  }
+  updateDisplay = true; // Mark that LCD should be updated after navigation
+}
+
+// Select or "enter" the current menu option or detail
+void selectMenuOption()
+{
+  if (menuLevel == 0)
+  {
+    // Main menu selection handling
+    switch (mainMenuIndex)
+    {
+    case 0:
+      menuLevel = 1; // Enter member list view
+      break;
+    case 1:
+      menuLevel = 4; // Wait for the card to give access to
+      break;
+    case 2:
+      menuLevel = 5; // Wait for the card to take access from
+      break;
+    case 3:
+      menuLevel = 6; // Show total number of members
+      break;
+    case 4:
+      // Bring the histogram up to date and start at the current hour
+      occupancyAdvance(clockNow());
+      occupancyHourIndex = currentOccupancyHour();
+      menuLevel = 3;
+      break;
+    }
+  }
+  else if (menuLevel == 1)
+  {
+    // From member list, enter detailed info view
+    menuLevel = 2;
+  }
+  updateDisplay = true; // Mark that LCD should be updated after selection
+}
+
+// Go back or exit current menu level
+void goBack()
+{
+  if (menuLevel == 2)
+  {
+    // From member details back to member list
+    menuLevel = 1;
+  }
+  else if (menuLevel == 3)
+  {
+    // From the occupancy page back to main menu
+    menuLevel = 0;
+  }
+  else if (menuLevel >= 4)
+  {
+    // From the add/remove access or total number page back to main menu
+    startFeedback();
+    addFeedbackScreen("Exiting...", "", 1000);
+    menuLevel = 0;
+  }
+  else if (menuLevel == 1)
+  {
+    // From member list back to main menu with a short message
+    startFeedback();
+    addFeedbackScreen("Exiting...", "", 1000);
+    menuLevel = 0;
+  }
+  updateDisplay = true; // Mark that LCD should be updated after going back
+}
+
+// Formats "<label><count> <unit>" for one LCD row, leaving the unit off when the count is
+// too long for both to fit
+static char *formatCount(const char *label, unsigned long count, const char *unit, char *out)
+{
+  if (snprintf(out, LCD_COLS + 1, "%s%lu %s", label, count, unit) > LCD_COLS)
+  {
+    snprintf(out, LCD_COLS + 1, "%s%lu", label, count);
+  }
+  return out;
+}
+
+// --- Function to update the LCD display based on current menu state ---
+
+void updateLCDMenu()
+{
+  if (menuLevel == 0)
+  {
+    // Display main menu options
+    lcd.clear();
+    switch (mainMenuIndex)
+    {
+    case 0:
+      lcd.print("See Members");
+      lcd.setCursor(3, 1);
+      lcd.print("--page 1--");
+      break;
+    case 1:
+      lcd.print("Add Access");
+      lcd.setCursor(3, 1);
+      lcd.print("--page 2--");
+      break;
+    case 2:
+      lcd.print("Remove Access");
+      lcd.setCursor(3, 1);
+      lcd.print("--page 3--");
+      break;
+    case 3:
+      lcd.print("Total Number");
+      lcd.setCursor(3, 1);
+      lcd.print("--page 4--");
+      break;
+    case 4:
+      lcd.print("Occupancy");
+      lcd.setCursor(3, 1);
+      lcd.print("--page 5--");
+      break;
+    default:
+      lcd.print("Default");
+      break;
+    }
+  }
+  else if (menuLevel == 3)
+  {
+    // Show peak and average occupancy for the selected hour of today
+    int peak = 0;
+    float average = 0;
+    getOccupancyHour(occupancyHourIndex, peak, average);
+
+    char hourLine[LCD_COLS + 1];
+    char averageLine[LCD_COLS + 1];
+    snprintf(hourLine, sizeof(hourLine), "%02d:00 Peak: %d", occupancyHourIndex, peak);
+    snprintf(averageLine, sizeof(averageLine), "Avg: %.1f", average);
+
+    lcd.clear();
+    lcd.print(hourLine);
+    lcd.setCursor(0, 1);
+    lcd.print(averageLine);
+  }
+  else if (menuLevel == 4)
+  {
+    // Waiting for the card to add, loop() hands it to adminCardScanned()
+    lcd.clear();
+    lcd.print("Scan new card...");
+  }
+  else if (menuLevel == 5)
+  {
+    // Waiting for the card to remove
+    lcd.clear();
+    lcd.print("Scan card to");
+    lcd.setCursor(0, 1);
+    lcd.print("Remove");
+  }
+  else if (menuLevel == 6)
+  {
+    showTotalNumber();
+  }
+  else if (uidCount == 0)
+  {
+    // No members registered
+    lcd.clear();
+    lcd.print("No Members");
+    menuLevel = 1;
+  }
+  else if (menuLevel == 1)
+  {
+    // Show selected member's name in member list
+    lcd.clear();
+    lcd.print(details_db[currentMemberIndex].name);
+    lcd.setCursor(3, 1);
+    lcd.print("--page ");
+    lcd.print(currentMemberIndex + 1);
+    lcd.print("--");
+  }
+  else if (menuLevel == 2)
+  {
+    // Show detailed info for selected member based on detailIndex page
+    lcd.clear();
+    switch (detailIndex)
+    {
+    case 0:
+    {
+      char uidHex[UID_HEX_SIZE];
+      lcd.print("UID: ");
+      lcd.print(formatCardUid(memberUids[currentMemberIndex], uidHex));
+      break;
+    }
+    case 1:
+      lcd.print("Logged: ");
+      lcd.print(memberLogged(currentMemberIndex) ? "Yes" : "No");
+      break;
+    case 2:
+      lcd.print("Last access:");
+      lcd.setCursor(0, 1);
+      if (details_db[currentMemberIndex].lastLogTime != 0)
+      {
+        char lastAccess[TIME_STRING_SIZE];
+        lcd.print(epochToString(details_db[currentMemberIndex].lastLogTime, lastAccess, sizeof(lastAccess)));
+      }
+      else
+      {
+        lcd.print("Never");
+      }
+      break;
+    case 3:
+    {
+      lcd.print("Last time spent:");
+      lcd.setCursor(0, 1);
+      char spentTime[SPENT_TIME_SIZE];
+      lcd.print(formatSpentTime(details_db[currentMemberIndex].lastTimeSpent, spentTime, sizeof(spentTime)));
+      break;
+    }
+    case 4:
+    case 5:
+    {
+      // This week's or this month's visits and time
+      sessionStats stats = currentSessionStats(currentMemberIndex, clockDateTime());
+      bool week = detailIndex == 4;
+      char countLine[LCD_COLS + 1];
+      char duration[LCD_COLS + 1];
+      lcd.print(formatCount(week ? "Week: " : "Month: ", week ? stats.weekSessions : stats.monthSessions, "visits",
+                            countLine));
+      lcd.setCursor(0, 1);
+      lcd.print(formatDuration(week ? stats.weekSeconds : stats.monthSeconds, duration, sizeof(duration)));
+      break;
+    }
+    case 6:
+    case 7:
+    {
+      // Moving average and shortest/longest session
+      const sessionStats &stats = details_db[currentMemberIndex].stats;
+      char top[LCD_COLS + 1];
+      char bottom[LCD_COLS + 1];
+      char first[LCD_COLS + 1];
+      char second[LCD_COLS + 1];
+      if (stats.sessions == 0)
+      {
+        lcd.print("No sessions yet");
+        break;
+      }
+      if (detailIndex == 6)
+      {
+        snprintf(top, sizeof(top), "Avg: %s", formatDuration(stats.averageSeconds, first, sizeof(first)));
+        formatCount("", stats.sessions, "sessions", bottom);
+      }
+      else
+      {
+        snprintf(top, sizeof(top), "Min: %s", formatDuration(stats.minSeconds, first, sizeof(first)));
+        snprintf(bottom, sizeof(bottom), "Max: %s", formatDuration(stats.maxSeconds, second, sizeof(second)));
+      }
+      lcd.print(top);
+      lcd.setCursor(0, 1);
+      lcd.print(bottom);
+      break;
+    }
+    default:
+      lcd.print("Default");
+      break;
+    }
+  }
+  updateDisplay = false; // Reset flag after updating display
+}
+
+// --- Main function that handles admin menu interaction using joystick input ---
+
+// Handles the next joystick event, if any; the joystick driver samples, debounces and
+// repeats the input in the background, so this never waits
+void adminLogged()
+{
+  JoystickEvent event;
+  if (nextJoystickEvent(event))
+  {
+    switch (event)
+    {
+    case JOYSTICK_LEFT:
+      navigateLeft();
+      break;
+    case JOYSTICK_RIGHT:
+      navigateRight();
+      break;
+    case JOYSTICK_SELECT:
+      selectMenuOption();
+      break;
+    case JOYSTICK_BACK:
+      goBack();
+      break;
+    }
+  }
+
+  // Update LCD if flagged
+  if (updateDisplay)
+  {
+    updateLCDMenu();
+  }
+}
+
+// Called with a member card scanned while admin mode is active
+void adminCardScanned(const CardUid &uid)
+{
+  if (menuLevel == 4)
+  {
+    addCardAccess(uid);
+  }
+  else if (menuLevel == 5)
+  {
+    removeCardAccess(uid);
+  }
+  else
+  {
+    return; // Member cards are ignored everywhere else in the menu
+  }
+  menuLevel = 0;        // Back to the main menu once the outcome has been shown
+  updateDisplay = true;
+}
+
+// --- Setup function to initialize hardware and peripherals ---
+
+void setup()
+{
+  Serial.begin(115200); // Start serial communication for debugging
+
+  // Initialize communication buses and devices
+  Wire.begin(LCD_SDA_PIN, LCD_SCL_PIN); // I2C for LCD
+  SPI.begin();                          // SPI for the RFID readers
+  startReaders();                       // Initialize the RFID readers
+  Rtc.Begin();                          // Initialize RTC
+  lcd.init();                           // Initialize LCD
+  lcd.backlight();                      // Turn on LCD backlight
+
+  // Set pins as outputs for LEDs and buzzer
+  pinMode(GREEN_PIN, OUTPUT);
+  pinMode(RED_PIN, OUTPUT);
+  pinMode(BLUE_PIN, OUTPUT);
+  pinMode(BUZZER_PIN, OUTPUT);
+
+  setupLEDControl(); // Setup PWM channels for LEDs
+
+  digitalWrite(BUZZER_PIN, HIGH); // Turn buzzer off initially (assuming active low)
+  turnOffLEDs();                  // Turn off all LEDs initially
+
+  Serial.println("Approximate your card to the reader...");
+
+  startClock(); // Take the time from the RTC, setting it only if it lost the time
+  startCrypto(); // Load the key attendance exports are sealed with
+
+  dht.begin();           // Initialize temperature and humidity sensor
+  startClimateSampler(); // Sample it in the background from now on
+
+  // Initialize joystick pins as inputs
+  pinMode(JOYSTICK_URX_PIN, INPUT);
+  pinMode(JOYSTICK_URY_PIN, INPUT);
+  pinMode(JOYSTICK_SW_PIN, INPUT);
+  startJoystick(); // Sample it in the background from now on
+
+  Serial.println("Setting up members...");
+  loadMembers();      // Restore the member table saved on flash
+  printMemberFootprint();
+  initOccupancy();    // Count members who were inside when the device went down
+  buildMemberIndex(); // Index the enrolled members for constant-time lookups
+  importRosterFile(ROSTER_PATH); // Apply a roster dropped onto the flash, if any
+
+  startReaderTask(); // Poll the RFID readers on the other core from now on
+}
+
+// --- Helper functions for handling card processing ---
+
+// Called when admin card is scanned and admin is not logged in
+void processAdminCard()
+{
+  adminAccessMelody(); // Play admin access melody and turn on LEDs
+  Serial.println("Admin Access Granted");
+  adminFlag = true;     // Set admin flag to true
+  updateDisplay = true; // Redraw the admin menu once the message has been shown
+  discardJoystickEvents(); // Only input from now on drives the menu
+
+  // Keep the message up for 2 seconds so user can read it
+  startFeedback();
+  addFeedbackScreen("Admin Access", "Granted", 2000);
+}
+
+// Called when admin card is scanned and admin is currently logged in (exit admin mode)
+void processAdminExit()
+{
+  adminGoodbyeMelody(); // Play admin exit melody
+  Serial.println("Admin Exited");
+  adminFlag = false; // Reset admin flag
+  if (menuLevel >= 4)
+  {
+    menuLevel = 0; // Do not come back to a half-finished add/remove on the next login
+  }
+
+  startFeedback();
+  addFeedbackScreen("Admin Exited", "", 2000);
+}
+
+// Records the time from card detection to the grant feedback starting, and has the next
+// LCD refresh timed as the first screen of the grant
+void markGrant()
+{
+#if LATENCY_PROBES
+  LATENCY_SINCE(LATENCY_GRANT, scanDetectedAtUs);
+  grantScreenPending = true;
+#endif
+}
+
+// Called when a member enters (logs in)
+void processMemberEntry(int index)
+{
+  accessGrantedMelody(); // Play access granted melody
+  markGrant();
+  LATENCY_START(clockStart);
+  EpochTime nowTime = clockNow();
+  RtcDateTime now(nowTime);
+  LATENCY_STOP(LATENCY_CLOCK, clockStart);
+  char nowString[TIME_STRING_SIZE];
+  timeToString(now, nowString, sizeof(nowString));
+
+  float temperature = 0, humidity = 0;
+  LATENCY_START(climateStart);
+  get_temperature_humidity(temperature, humidity);
+  LATENCY_STOP(LATENCY_CLIMATE, climateStart);
+
+  memberDetails &details = details_db[index];
+  char lastAccess[TIME_STRING_SIZE];
+  Serial.println(epochToString(details.lastLogTime, lastAccess, sizeof(lastAccess)));
+  if (memberLogged(index))
+  {
+    Serial.println("No exit on record, restarting the session");
+  }
+  setMemberLogged(index, true, nowTime); // Mark member as logged in
+  details.lastLogTime = nowTime;         // Record last access time
+  logAttendanceEvent(nowTime, index, ATTENDANCE_ENTRY, temperature, humidity);
+  LATENCY_START(storeStart);
+  storeMember(index); // Persist the new state
+  LATENCY_STOP(LATENCY_STORE, storeStart);
+
+  Serial.println("Access Granted");
+  Serial.println("Welcome");
+
+  char temperatureLine[LCD_COLS + 1];
+  char humidityLine[LCD_COLS + 1];
+  snprintf(temperatureLine, sizeof(temperatureLine), "Temp: %.2fC", temperature);
+  snprintf(humidityLine, sizeof(humidityLine), "Humidity: %.2f%%", humidity);
+
+  // Queue the entry screens, loop() shows them while it keeps polling the reader
+  startFeedback();
+  addFeedbackScreen("Access Granted", nowString, 1000);
+  addFeedbackScreen("Welcome", details.name, 1500);
+  addFeedbackScreen(temperatureLine, humidityLine, 1500);
+}
+
+// Called when a member exits (logs out)
+void processMemberExit(int index)
+{
+  goodbyeMelody(); // Play goodbye melody
+  markGrant();
+  LATENCY_START(clockStart);
+  EpochTime nowTime = clockNow();
+  RtcDateTime now(nowTime);
+  LATENCY_STOP(LATENCY_CLOCK, clockStart);
+  char nowString[TIME_STRING_SIZE];
+  Serial.println(timeToString(now, nowString, sizeof(nowString)));
+
+  setMemberLogged(index, false, nowTime); // Mark member as logged out
+
+  float temperature = 0, humidity = 0;
+  LATENCY_START(climateStart);
+  get_temperature_humidity(temperature, humidity);
+  LATENCY_STOP(LATENCY_CLIMATE, climateStart);
+  logAttendanceEvent(nowTime, index, ATTENDANCE_EXIT, temperature, humidity);
+
+  Serial.println("Logging out...");
+
+  // Queue the exit screens followed by the time spent information
+  startFeedback();
+  addFeedbackScreen("Left at ", nowString, 2000);
+  displayExitTime(now, index);
+  printSessionStats(index, now);
+  LATENCY_START(storeStart);
+  storeMember(index); // Persist logout, time spent and session statistics
+  LATENCY_STOP(LATENCY_STORE, storeStart);
+}
+
+// Called when a member badges out on an exit reader without an entry on record, so there
+// is no session to close
+void processStrayExit(int index)
+{
+  goodbyeMelody();
+  markGrant();
+  EpochTime nowTime = clockNow();
+
+  float temperature = 0, humidity = 0;
+  get_temperature_humidity(temperature, humidity);
+  logAttendanceEvent(nowTime, index, ATTENDANCE_EXIT, temperature, humidity);
+
+  Serial.println("No entry on record");
+
+  startFeedback();
+  addFeedbackScreen("Goodbye", details_db[index].name, 1500);
+}
+
+// Called when an unknown or revoked card is scanned
+void processAccessDenied()
+{
+  // Past the rate limit a denial is only counted
+  if (!allowDenialFeedback())
+  {
+    return;
+  }
+
+  accessDeniedMelody(); // Unauthorized access attempt feedback
+  Serial.println("Access Denied");
+
+  startFeedback();
+  addFeedbackScreen("Access Denied", "", 2000);
+}
+
+// Counts processed scans and reports the sustained rate, LCD bus traffic and climate once per minute
+void reportScanRate(bool scanned)
+{
+  static unsigned long windowStart = 0;
+  static unsigned int scansInWindow = 0;
+  static unsigned long lcdBytesAtStart = 0;
+  static unsigned long lcdTransactionsAtStart = 0;
+
+  if (scanned)
+  {
+    scansInWindow++;
+  }
+
+  if (millis() - windowStart >= 60000)
+  {
+    if (scansInWindow > 0)
+    {
+      Serial.print("Scans in last minute: ");
+      Serial.println(scansInWindow);
+    }
+    if (scansSuppressed > 0)
+    {
+      Serial.print("Card re-reads suppressed since boot: ");
+      Serial.println(scansSuppressed);
+    }
+    if (denialStats.denied > 0)
+    {
+      Serial.print("Denied scans since boot: ");
+      Serial.print(denialStats.denied);
+      Serial.print(" (");
+      Serial.print(denialStats.cached);
+      Serial.print(" from cache, ");
+      Serial.print(denialStats.limited);
+      Serial.println(" rate limited)");
+    }
+    if (scansDropped > 0)
+    {
+      Serial.print("Scans dropped (queue full) since boot: ");
+      Serial.println(scansDropped);
+    }
+    if (joystickEventsDropped > 0)
+    {
+      Serial.print("Joystick events dropped (menu behind) since boot: ");
+      Serial.println(joystickEventsDropped);
+    }
+    Serial.print("LCD I2C in last minute: ");
+    Serial.print(lcd.i2cBytes() - lcdBytesAtStart);
+    Serial.print(" bytes in ");
+    Serial.print(lcd.i2cTransactions() - lcdTransactionsAtStart);
+    Serial.println(" transactions");
+    printClimateStats();
+    lcdBytesAtStart = lcd.i2cBytes();
+    lcdTransactionsAtStart = lcd.i2cTransactions();
+    scansInWindow = 0;
+    windowStart = millis();
+  }
+}
+
+// --- Main program loop ---
+
+void loop()
+{
+  bool scanned = false;
+
+  updateClimate(); // Pick up the sampler's newest climate reading
+
+  // Take the next card from the reader task regardless of admin mode or a running
+  // feedback sequence, a new card simply takes over the display from the previous one
+  ScanEvent scan;
+  if (nextScan(scan))
+  {
+    scanned = true;
+#if LATENCY_PROBES
+    LATENCY_SINCE(LATENCY_QUEUE, scan.readAtUs);
+    scanDetectedAtUs = scan.detectedAtUs;
+#endif
+    CardUid readUID = scan.uid;
+
+    if (readUID == adminUid)
+    {
+      // Toggle admin mode on/off when admin card is scanned
+      if (!adminFlag)
+      {
+        processAdminCard();
+      }
+      else
+      {
+        processAdminExit();
+      }
+      // Do NOT return here to allow processing below
+    }
+    else if (adminFlag)
+    {
+      // If in admin mode, member cards only matter to the add/remove access pages
+      // No return, so menu keeps updating below
+      adminCardScanned(readUID);
+    }
+    else
+    {
+      // If not in admin mode, check member access and log entry/exit
+      // One index probe gives both the member and its access status, and cards
+      // denied a moment ago are answered without one
+      LATENCY_START(lookupStart);
+      MemberLookup member = checkMemberAccess(readUID);
+      LATENCY_STOP(LATENCY_LOOKUP, lookupStart);
+      if (member.hasAccess)
+      {
+        int index = member.index;
+        // The serial log names members by number only, their UIDs and names stay off the wire
+        Serial.print("Member ");
+        Serial.print(index);
+        Serial.println(" has access");
+        // The reader gives the direction; a toggle reader goes by whether the member is in
+        ReaderRole role = readerConfigs[scan.reader].role;
+        bool entering = role == READER_TOGGLE ? !memberLogged(index) : role == READER_ENTRY;
+        if (entering)
+        {
+          processMemberEntry(index);
+        }
+        else if (memberLogged(index))
+        {
+          processMemberExit(index);
+        }
+        else
+        {
+          processStrayExit(index);
+        }
+      }
+      else
+      {
+        processAccessDenied();
+      }
+      // No return here to allow idle display below if needed
+    }
+  }
+
+  reportScanRate(scanned);
+  flushAttendanceLog(false); // Export buffered attendance events in batches
+  pollConsole();             // Serial commands, including roster imports
+  updateClock();             // Resync the software clock from the RTC now and then
+
+  // Advance the entry/exit/admin screens; they own the display until finished
+  if (!updateFeedback())
+  {
+    // If admin mode is active, handle admin menu interaction
+    if (adminFlag)
+    {
+      adminLogged();
+    }
+    else
+    {
+      // If not admin, show idle message on LCD
+      printIdle();
+      discardJoystickEvents(); // The joystick only drives the admin menu
+    }
+  }
+  else
+  {
+    discardJoystickEvents(); // Input during a feedback screen is not meant for the menu
+  }
+
+  // Send whatever changed on the screen this pass in one I2C transaction
+  LATENCY_START(lcdStart);
+  lcd.refresh();
+#if LATENCY_PROBES
+  if (grantScreenPending)
+  {
+    LATENCY_STOP(LATENCY_LCD, lcdStart);
+    LATENCY_SINCE(LATENCY_SCREEN, scanDetectedAtUs);
+    grantScreenPending = false;
+  }
+#endif
+}
@@ -0,0 +1,94 @@
+#ifndef MEMBER_INDEX_HPP
+#define MEMBER_INDEX_HPP
+
+#include <card_uid.hpp>
+
+// Result of a member lookup: the member's position in the member table and whether it may enter
+struct MemberLookup
+{
+    int index;      // -1 if the card is not enrolled
+    bool hasAccess; // false for unknown and revoked cards
+};
+
+// Open-addressing hash index from binary UID to member.
+// The UIDs themselves stay in the member table's dense UID array; a slot only holds the
+// member number and a 16-bit hash tag, so a probe touches the UID array only when the
+// tag already matches. SLOTS must be a power of two and should be at least twice the
+// number of members so probe sequences stay short. Members are never deleted (revoking
+// only clears access), so linear probing needs no tombstones.
+template <int SLOTS>
+class MemberIndex
+{
+    static_assert(SLOTS > 0 && (SLOTS & (SLOTS - 1)) == 0, "SLOTS must be a power of two");
+
+public:
+    explicit MemberIndex(const CardUid *uids) : uids(uids) { clear(); }
+
+    // Function to remove every entry from the index
+    void clear()
+    {
+        for (int i = 0; i < SLOTS; i++)
+        {
+            slots[i].member = -1;
+        }
+        count = 0;
+    }
+
+    // Function to index member `member`, whose UID is already stored in the UID array.
+    // Returns false when the index is full or the UID is already indexed.
+    bool insert(int member)
+    {
+        const CardUid &uid = uids[member];
+        uint32_t h = cardUidHash(uid);
+        int slot = probe(uid, h);
+        // Keep at least one empty slot so probes always terminate
+        if (slot < 0 || slots[slot].member >= 0 || count >= SLOTS - 1)
+        {
+            return false;
+        }
+        slots[slot].member = member;
+        slots[slot].tag = h >> 16;
+        count++;
+        return true;
+    }
+
+    // Function to look up a UID, returning its member number or -1
+    int find(const CardUid &uid) const
+    {
+        int slot = probe(uid, cardUidHash(uid));
+        return slot < 0 ? -1 : slots[slot].member;
+    }
+
+    int size() const { return count; }
+
+private:
+    struct entry
+    {
+        int16_t member; // -1 marks an empty slot
+        uint16_t tag;   // Upper hash bits, checked before comparing UIDs
+    };
+
+    // Function to find the slot holding the UID, or the empty slot where it would go.
+    // Returns -1 only if the table is completely full and the UID is absent.
+    int probe(const CardUid &uid, uint32_t h) const
+    {
+        uint16_t tag = h >> 16;
+        int slot = h & (SLOTS - 1);
+        for (int i = 0; i < SLOTS; i++)
+        {
+            const entry &e = slots[slot];
+            if (e.member < 0 || (e.tag == tag && uids[e.member] == uid))
+            {
+                return slot;
+            }
+            slot = (slot + 1) & (SLOTS - 1);
+        }
+        return -1;
+    }
+
+    const CardUid *uids;
+    entry slots[SLOTS];
+    int count;
+};
+
+#endif // MEMBER_INDEX_HPP
@@ -0,0 +1,120 @@
+#include <utils.hpp>
+
+// Occupancy tracking.
+// occupancyCount is kept up to date by setMemberLogged(), so reading how many members are
+// inside never scans the member table. Every change is also folded into a per-hour
+// histogram of today's occupancy: the peak seen in each hour and the time-weighted
+// average (member-seconds divided by observed seconds).
+
+// One hour of the occupancy histogram
+struct occupancyHour
+{
+    uint16_t peak;             // Highest occupancy seen during the hour
+    uint32_t memberSeconds;    // Occupancy integrated over the observed time
+    uint32_t observedSeconds;  // Seconds of the hour covered so far
+};
+
+int occupancyCount = 0;
+
+static occupancyHour occupancyHistogram[24];
+static bool histogramStarted = false; // Whether any time has been integrated yet
+static uint32_t histogramDay = 0;     // Day the histogram belongs to (days since 2000-01-01)
+static EpochTime lastTimestamp = 0;   // Time up to which occupancy has been integrated
+static int lastHour = 0;              // Hour of lastTimestamp
+
+// Function to count the members already inside, called once after the member table is loaded
+void initOccupancy()
+{
+    occupancyCount = 0;
+    for (int word = 0; word < BITSET_WORDS(uidCount); word++)
+    {
+        occupancyCount += __builtin_popcount(memberLoggedBits[word]);
+    }
+}
+
+// Function to integrate the current occupancy up to `timestamp`.
+// Intervals are split at hour boundaries; the histogram starts over when a new day begins.
+void occupancyAdvance(EpochTime timestamp)
+{
+    // First sample, or the clock went backwards: just restart from here
+    if (!histogramStarted || timestamp < lastTimestamp)
+    {
+        lastTimestamp = timestamp;
+    }
+
+    // Nothing from a previous day survives, so skip straight to today's midnight
+    uint32_t today = timestamp / SECONDS_PER_DAY;
+    if (lastTimestamp / SECONDS_PER_DAY != today)
+    {
+        lastTimestamp = max(lastTimestamp, (EpochTime)(today * SECONDS_PER_DAY));
+    }
+
+    while (true)
+    {
+        uint32_t day = lastTimestamp / SECONDS_PER_DAY;
+        if (!histogramStarted || day != histogramDay)
+        {
+            memset(occupancyHistogram, 0, sizeof(occupancyHistogram));
+            histogramDay = day;
+            histogramStarted = true;
+        }
+
+        lastHour = (lastTimestamp % SECONDS_PER_DAY) / SECONDS_PER_HOUR;
+        occupancyHour &bucket = occupancyHistogram[lastHour];
+        if (occupancyCount > bucket.peak)
+        {
+            bucket.peak = occupancyCount;
+        }
+
+        EpochTime hourEnd = (lastTimestamp / SECONDS_PER_HOUR + 1) * SECONDS_PER_HOUR;
+        EpochTime until = min(hourEnd, timestamp);
+        bucket.observedSeconds += until - lastTimestamp;
+        bucket.memberSeconds += (uint32_t)occupancyCount * (until - lastTimestamp);
+
+        lastTimestamp = until;
+        if (until >= timestamp)
+        {
+            break;
+        }
+    }
+
+    // Point at the bucket for `timestamp` itself, which may have just started
+    if (timestamp / SECONDS_PER_DAY != histogramDay)
+    {
+        memset(occupancyHistogram, 0, sizeof(occupancyHistogram));
+        histogramDay = timestamp / SECONDS_PER_DAY;
+    }
+    lastHour = (timestamp % SECONDS_PER_DAY) / SECONDS_PER_HOUR;
+    if (occupancyCount > occupancyHistogram[lastHour].peak)
+    {
+        occupancyHistogram[lastHour].peak = occupancyCount;
+    }
+}
+
+// Function to apply an entry (+1) or exit (-1) that happened at `timestamp`
+void recordOccupancyChange(int delta, EpochTime timestamp)
+{
+    occupancyAdvance(timestamp);
+    occupancyCount = max(0, occupancyCount + delta);
+
+    occupancyHour &bucket = occupancyHistogram[lastHour];
+    if (occupancyCount > bucket.peak)
+    {
+        bucket.peak = occupancyCount;
+    }
+}
+
+// Function to read one hour of today's histogram.
+// The average is 0 for hours that have not been observed yet.
+void getOccupancyHour(int hour, int &peak, float &average)
+{
+    const occupancyHour &bucket = occupancyHistogram[hour];
+    peak = bucket.peak;
+    average = bucket.observedSeconds > 0 ? (float)bucket.memberSeconds / bucket.observedSeconds : 0.0;
+}
+
+// Function to get the hour the histogram was last updated for
+int currentOccupancyHour()
+{
+    return lastHour;
+}
@@ -0,0 +1,116 @@
+#include <utils.hpp>
+#include <recent_cards.hpp>
+#include <spsc_queue.hpp>
+
+// RFID reader task.
+// The readers are polled by their own service pinned to READER_CORE, away from loop(), so
+// the LCD, buzzer and DHT on the other core never hold up card detection and a slow
+// poll never holds up the UI. Each card read is decoded and handed over through a
+// lock-free single-producer/single-consumer queue; the reader task is the only user of
+// the MFRC522s and their SPI bus.
+//
+// Up to MAX_READERS readers share SCK, MISO and MOSI, each with its own chip select. Every
+// step of the task is one round that polls each reader once, and reads at most one card
+// from it, so a reader with a stream of cards cannot starve the others. Each round starts
+// one reader further on, so no reader always waits for the rest. A poll that finds no card
+// waits out the MFRC522's receive timeout, so each reader's polling rate falls with the
+// number of readers on the bus (badge_sim bench measures it).
+//
+// A card is halted as soon as it has been read, so one resting on the antenna stays
+// silent instead of answering every other poll. A card that drifts out of the field
+// and back, or is tapped twice, is read again though; the last-seen cache drops such
+// re-reads within REREAD_WINDOW_MS so they never reach the queue or the UI. The cache is
+// shared by the readers, so a card held where two antennas reach it counts once.
+
+static SpscQueue<ScanEvent, SCAN_QUEUE_SIZE> scanQueue;
+static RecentCards<REREAD_CACHE_SIZE> recentCards;
+static MFRC522 readers[MAX_READERS];
+static int firstReader = 0; // Reader polled first in the next round
+SharedCounter scansDropped;    // Scans lost because the UI fell SCAN_QUEUE_SIZE scans behind
+SharedCounter scansSuppressed; // Re-reads of a card within REREAD_WINDOW_MS
+ReaderCounters readerCounters[MAX_READERS];
+
+// Function to set up every configured reader, called once from setup() after SPI.begin()
+void startReaders()
+{
+    // Deselect them all first, so none answers on the bus while another is being set up
+    for (int i = 0; i < readerCount; i++)
+    {
+        pinMode(readerConfigs[i].chipSelectPin, OUTPUT);
+        digitalWrite(readerConfigs[i].chipSelectPin, HIGH);
+    }
+    for (int i = 0; i < readerCount; i++)
+    {
+        readers[i].PCD_Init(readerConfigs[i].chipSelectPin, RST_PIN);
+    }
+}
+
+// Function to poll one reader once
+static void pollReader(uint8_t index)
+{
+    MFRC522 &reader = readers[index];
+    readerCounters[index].polls.increment();
+    LATENCY_STAMP(detectedAtUs);
+    LATENCY_START(detectStart);
+    if (!reader.PICC_IsNewCardPresent())
+    {
+        return;
+    }
+    LATENCY_STOP(LATENCY_DETECT, detectStart);
+
+    LATENCY_START(readStart);
+    if (!reader.PICC_ReadCardSerial())
+    {
+        return;
+    }
+    LATENCY_STOP(LATENCY_READ, readStart);
+    readerCounters[index].scans.increment();
+
+    LATENCY_START(decodeStart);
+    ScanEvent scan;
+    scan.uid = convertUID(reader.uid);
+    scan.readAt = millis();
+    scan.reader = index;
+#if LATENCY_PROBES
+    scan.detectedAtUs = detectedAtUs;
+    scan.readAtUs = micros();
+#endif
+    bool repeat = recentCards.seenWithin(scan.uid, scan.readAt, REREAD_WINDOW_MS);
+    LATENCY_STOP(LATENCY_DECODE, decodeStart);
+
+    if (repeat)
+    {
+        scansSuppressed.increment();
+    }
+    else if (!scanQueue.push(scan))
+    {
+        scansDropped.increment();
+    }
+
+    // Put the card to sleep until it leaves the field, and end any authenticated session
+    reader.PICC_HaltA();
+    reader.PCD_StopCrypto1();
+}
+
+// Function to poll every reader once, run over and over by the reader task
+static void pollReaders()
+{
+    int count = readerCount;
+    for (int i = 0; i < count; i++)
+    {
+        pollReader((firstReader + i) % count);
+    }
+    firstReader = (firstReader + 1) % count;
+}
+
+// Function to start polling the readers in the background, called once from setup()
+void startReaderTask()
+{
+    halStartService("rfid", pollReaders, READER_CORE);
+}
+
+// Function to take the oldest scan not yet handled. Returns false if there is none.
+bool nextScan(ScanEvent &scan)
+{
+    return scanQueue.pop(scan);
+}
@@ -0,0 +1,60 @@
+#ifndef RECENT_CARDS_HPP
+#define RECENT_CARDS_HPP
+
+#include <card_uid.hpp>
+
+// Last-seen cache of recently read cards.
+// Remembers when each of the last SIZE distinct cards was read, so a card read again
+// within the suppression window can be recognised with one pass over a few entries and
+// dropped before it costs any UI work. Every read, suppressed or not, refreshes the
+// card's time, so a badge left lying on the antenna stays suppressed however often the
+// reader picks it up again. When the cache is full the least recently seen card makes
+// room. Not thread-safe: only the reader task uses it.
+template <int SIZE>
+class RecentCards
+{
+    static_assert(SIZE > 0, "RecentCards needs at least one entry");
+
+public:
+    RecentCards() : used(0) {}
+
+    // Function to record a read of `uid` at `now` (milliseconds). Returns true if the same
+    // card had already been read less than `windowMs` earlier.
+    bool seenWithin(const CardUid &uid, unsigned long now, unsigned long windowMs)
+    {
+        int oldest = 0;
+        for (int i = 0; i < used; i++)
+        {
+            if (entries[i].uid == uid)
+            {
+                bool recent = now - entries[i].seenAt < windowMs;
+                entries[i].seenAt = now;
+                return recent;
+            }
+            if (now - entries[i].seenAt > now - entries[oldest].seenAt)
+            {
+                oldest = i;
+            }
+        }
+
+        int slot = used < SIZE ? used++ : oldest;
+        entries[slot].uid = uid;
+        entries[slot].seenAt = now;
+        return false;
+    }
+
+    // Function to forget every card, so the next read of any card counts as new
+    void clear() { used = 0; }
+
+private:
+    struct entry
+    {
+        CardUid uid;
+        unsigned long seenAt;
+    };
+
+    entry entries[SIZE];
+    int used;
+};
+
+#endif // RECENT_CARDS_HPP
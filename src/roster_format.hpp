@@ -0,0 +1,358 @@
+#ifndef ROSTER_FORMAT_HPP
+#define ROSTER_FORMAT_HPP
+
+// Roster formats for provisioning many members in one batch.
+// Shared by the firmware (importer) and the host-side packer in tools/, so it only
+// depends on the C standard headers.
+//
+// A roster is either CSV text, one member per line:
+//   uid,name,access
+// uid is 2..20 hex digits, name is cut to ROSTER_NAME_MAX characters and may not contain
+// commas, access is 1 or 0 (1 if left out). Empty lines, lines starting with '#' and a
+// header line starting with "uid" are skipped. A line reading "end" closes the roster,
+// which is how a roster sent over serial is terminated.
+//
+// Or a compact binary image, all multi-byte fields little-endian:
+//   'B' 'D' 'G' 'R'      magic
+//   version    (1)       ROSTER_IMAGE_VERSION
+//   count      (4)       records that follow
+//   records    (count)   see below
+//   crc        (4)       CRC-32 of everything from version to the last record
+//
+// Record layout (2 to ROSTER_RECORD_MAX_BYTES bytes):
+//   flags      (1)       ROSTER_HAS_ACCESS
+//   uidSize    (1)       1..UID_MAX_BYTES
+//   uid        (uidSize)
+//   nameLength (1)       0..ROSTER_NAME_MAX
+//   name       (nameLength), not terminated
+
+#include <card_uid.hpp>
+#include <crc.hpp>
+
+#define ROSTER_MAGIC "BDGR"
+#define ROSTER_IMAGE_VERSION 1
+#define ROSTER_HEADER_BYTES 9
+#define ROSTER_CRC_BYTES 4
+#define ROSTER_NAME_MAX 23 // Characters, matching the member table's name field
+#define ROSTER_RECORD_MAX_BYTES (3 + UID_MAX_BYTES + ROSTER_NAME_MAX)
+#define ROSTER_LINE_MAX 80 // Longest CSV line accepted, without the line ending
+
+#define ROSTER_HAS_ACCESS 0x01
+
+// One member as described by a roster
+struct RosterRecord
+{
+    CardUid uid;
+    char name[ROSTER_NAME_MAX + 1];
+    bool hasAccess;
+};
+
+// Function to write the binary image header for `count` records into `out`
+// (ROSTER_HEADER_BYTES). The CRC starts after the magic, at out + 4.
+inline size_t encodeRosterHeader(uint32_t count, uint8_t *out)
+{
+    memcpy(out, ROSTER_MAGIC, 4);
+    out[4] = ROSTER_IMAGE_VERSION;
+    for (int i = 0; i < 4; i++)
+    {
+        out[5 + i] = (count >> (8 * i)) & 0xFF;
+    }
+    return ROSTER_HEADER_BYTES;
+}
+
+// Function to encode one record into `out` (ROSTER_RECORD_MAX_BYTES). Returns its length.
+inline size_t encodeRosterRecord(const RosterRecord &record, uint8_t *out)
+{
+    size_t nameLength = strnlen(record.name, ROSTER_NAME_MAX);
+    uint8_t *p = out;
+    *p++ = record.hasAccess ? ROSTER_HAS_ACCESS : 0;
+    *p++ = record.uid.size;
+    memcpy(p, record.uid.bytes, record.uid.size);
+    p += record.uid.size;
+    *p++ = (uint8_t)nameLength;
+    memcpy(p, record.name, nameLength);
+    return p + nameLength - out;
+}
+
+// Function to write the image's closing CRC into `out` (ROSTER_CRC_BYTES)
+inline size_t encodeRosterCrc(uint32_t crc, uint8_t *out)
+{
+    for (int i = 0; i < ROSTER_CRC_BYTES; i++)
+    {
+        out[i] = (crc >> (8 * i)) & 0xFF;
+    }
+    return ROSTER_CRC_BYTES;
+}
+
+// Streaming roster parser.
+// Bytes can be fed in chunks of any size as they arrive; every complete member is handed
+// to `sink` straight away, so a roster of any length is parsed in one pass with no more
+// memory than one line. The format is recognised from the first bytes.
+//
+// A malformed CSV line is skipped and counted. A binary image is only known to be intact
+// once its CRC has been checked at the end, so a caller that applies records as they
+// arrive has to undo them when finish() returns false.
+class RosterParser
+{
+public:
+    typedef void (*Sink)(const RosterRecord &record, void *context);
+
+    RosterParser(Sink sink, void *context) : sink_(sink), context_(context) {}
+
+    // Function to parse the next `length` bytes of the roster
+    void feed(const uint8_t *data, size_t length)
+    {
+        for (size_t i = 0; i < length && state_ != DONE && state_ != FAILED; i++)
+        {
+            if (state_ == SNIFFING)
+            {
+                sniff(data[i]);
+            }
+            else if (state_ == CSV)
+            {
+                csvByte(data[i]);
+            }
+            else
+            {
+                binaryByte(data[i]);
+            }
+        }
+    }
+
+    // Function to signal the end of the input. Returns true if the whole roster was valid:
+    // always for CSV (bad lines are only counted), only with a matching CRC for binary.
+    bool finish()
+    {
+        if (state_ == SNIFFING || state_ == CSV)
+        {
+            if (lineLength_ > 0 || overlong_)
+            {
+                endLine();
+            }
+            state_ = DONE;
+        }
+        else if (state_ != DONE)
+        {
+            state_ = FAILED; // Binary image cut short
+        }
+        return state_ == DONE;
+    }
+
+    // True once the roster closed itself: an "end" line or the end of a binary image
+    bool done() const { return state_ == DONE || state_ == FAILED; }
+    bool failed() const { return state_ == FAILED; }
+    bool binary() const { return binary_; }
+    unsigned long records() const { return records_; }
+    unsigned long rejected() const { return rejected_; }
+
+private:
+    enum parserState
+    {
+        SNIFFING,
+        CSV,
+        DONE,
+        FAILED,
+        BINARY_VERSION,
+        BINARY_COUNT,
+        BINARY_FLAGS,
+        BINARY_UID_SIZE,
+        BINARY_UID,
+        BINARY_NAME_LENGTH,
+        BINARY_NAME,
+        BINARY_CRC
+    };
+
+    // Function to tell CSV from binary by the first bytes: anything that stops matching
+    // the magic is the start of a CSV line. Leading line endings (left over from the
+    // command that started a serial import) are skipped.
+    void sniff(uint8_t byte)
+    {
+        if (lineLength_ == 0 && (byte == '\r' || byte == '\n'))
+        {
+            return;
+        }
+        if (lineLength_ < 4 && byte == (uint8_t)ROSTER_MAGIC[lineLength_])
+        {
+            line_[lineLength_++] = byte;
+            if (lineLength_ == 4)
+            {
+                lineLength_ = 0;
+                binary_ = true;
+                state_ = BINARY_VERSION;
+            }
+            return;
+        }
+        state_ = CSV;
+        csvByte(byte);
+    }
+
+    void csvByte(uint8_t byte)
+    {
+        if (byte == '\n')
+        {
+            endLine();
+        }
+        else if (byte != '\r')
+        {
+            if (lineLength_ < ROSTER_LINE_MAX)
+            {
+                line_[lineLength_++] = byte;
+            }
+            else
+            {
+                overlong_ = true;
+            }
+        }
+    }
+
+    // Function to parse the buffered CSV line
+    void endLine()
+    {
+        line_[lineLength_] = '\0';
+        size_t length = lineLength_;
+        bool overlong = overlong_;
+        lineLength_ = 0;
+        overlong_ = false;
+
+        if (length == 0 || line_[0] == '#' || (records_ == 0 && rejected_ == 0 && strncmp(line_, "uid", 3) == 0))
+        {
+            return;
+        }
+        if (strcmp(line_, "end") == 0)
+        {
+            state_ = DONE;
+            return;
+        }
+
+        // Split into up to three fields in place
+        char *fields[3] = {line_, NULL, NULL};
+        int count = 1;
+        for (char *p = line_; *p && count < 3; p++)
+        {
+            if (*p == ',')
+            {
+                *p = '\0';
+                fields[count++] = p + 1;
+            }
+        }
+
+        RosterRecord record;
+        record.hasAccess = true;
+        if (overlong || !parseCardUid(fields[0], record.uid) || (count > 2 && !parseAccess(fields[2], record.hasAccess)))
+        {
+            rejected_++;
+            return;
+        }
+        const char *name = count > 1 ? fields[1] : "";
+        size_t nameLength = strnlen(name, ROSTER_NAME_MAX);
+        memcpy(record.name, name, nameLength);
+        record.name[nameLength] = '\0';
+        emit(record);
+    }
+
+    static bool parseAccess(const char *text, bool &hasAccess)
+    {
+        if (strcmp(text, "1") == 0 || strcmp(text, "0") == 0)
+        {
+            hasAccess = text[0] == '1';
+            return true;
+        }
+        return false;
+    }
+
+    void binaryByte(uint8_t byte)
+    {
+        if (state_ != BINARY_CRC)
+        {
+            crc_ = crc32(&byte, 1, crc_);
+        }
+
+        switch (state_)
+        {
+        case BINARY_VERSION:
+            state_ = byte == ROSTER_IMAGE_VERSION ? BINARY_COUNT : FAILED;
+            break;
+        case BINARY_COUNT:
+            remaining_ |= (uint32_t)byte << (8 * fieldBytes_);
+            if (++fieldBytes_ == 4)
+            {
+                fieldBytes_ = 0;
+                state_ = remaining_ ? BINARY_FLAGS : BINARY_CRC;
+            }
+            break;
+        case BINARY_FLAGS:
+            record_.hasAccess = byte & ROSTER_HAS_ACCESS;
+            state_ = BINARY_UID_SIZE;
+            break;
+        case BINARY_UID_SIZE:
+            record_.uid.size = byte;
+            state_ = byte >= 1 && byte <= UID_MAX_BYTES ? BINARY_UID : FAILED;
+            break;
+        case BINARY_UID:
+            record_.uid.bytes[fieldBytes_++] = byte;
+            if (fieldBytes_ == record_.uid.size)
+            {
+                fieldBytes_ = 0;
+                state_ = BINARY_NAME_LENGTH;
+            }
+            break;
+        case BINARY_NAME_LENGTH:
+            nameLength_ = byte;
+            state_ = byte > ROSTER_NAME_MAX ? FAILED : byte ? BINARY_NAME : BINARY_FLAGS;
+            if (byte == 0)
+            {
+                endRecord();
+            }
+            break;
+        case BINARY_NAME:
+            record_.name[fieldBytes_++] = byte;
+            if (fieldBytes_ == nameLength_)
+            {
+                fieldBytes_ = 0;
+                endRecord();
+            }
+            break;
+        case BINARY_CRC:
+            expectedCrc_ |= (uint32_t)byte << (8 * fieldBytes_);
+            if (++fieldBytes_ == 4)
+            {
+                state_ = expectedCrc_ == crc_ ? DONE : FAILED;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Function to hand over a complete binary record and move on to the next one
+    void endRecord()
+    {
+        record_.name[nameLength_] = '\0';
+        emit(record_);
+        state_ = --remaining_ ? BINARY_FLAGS : BINARY_CRC;
+    }
+
+    void emit(const RosterRecord &record)
+    {
+        records_++;
+        sink_(record, context_);
+    }
+
+    Sink sink_;
+    void *context_;
+    parserState state_ = SNIFFING;
+    bool binary_ = false;
+    char line_[ROSTER_LINE_MAX + 1];
+    size_t lineLength_ = 0;
+    bool overlong_ = false;
+    RosterRecord record_;
+    uint8_t nameLength_ = 0;
+    uint8_t fieldBytes_ = 0;
+    uint32_t remaining_ = 0;
+    uint32_t crc_ = 0;
+    uint32_t expectedCrc_ = 0;
+    unsigned long records_ = 0;
+    unsigned long rejected_ = 0;
+};
+
+#endif // ROSTER_FORMAT_HPP
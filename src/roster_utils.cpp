@@ -0,0 +1,274 @@
+#include <utils.hpp>
+#include <roster_format.hpp>
+
+// Roster import.
+// A whole roster (see roster_format.hpp) is streamed through RosterParser from a flash
+// file or from serial. The member table is not touched until the roster has been checked
+// whole: a file is parsed once to validate it and once more to apply it, and a serial
+// roster is spooled to ROSTER_SPOOL_PATH as it arrives, validated on the way in and then
+// applied from the spool. The apply pass runs inside a single loop() pass, so scans and
+// the admin menu only ever see the table from before the roster or after it, and a
+// corrupt roster needs nothing undone.
+// Applying, members already enrolled are found through the index, which is left alone
+// during the pass, and new ones are appended. Then the index is extended (folding
+// duplicate UIDs within the roster into one member) and the snapshot written, once for
+// the whole batch.
+//
+// A serial import does not hold up loop(): the console's "roster" command starts it and
+// pollRosterSerial() spools whatever has arrived on each pass, so scanning, feedback and
+// the clock carry on while the roster streams in. Access changes from the admin menu
+// wait until it is done.
+
+static_assert(STORED_NAME_SIZE == ROSTER_NAME_MAX + 1, "roster names must fit the member table");
+
+#define ROSTER_READ_CHUNK 256         // Bytes read per file access
+#define ROSTER_SERIAL_TIMEOUT_MS 5000 // Serial silence that aborts an import
+
+// Counters for the batch in progress
+struct rosterBatch
+{
+    int firstNew; // uidCount when the batch started
+    unsigned long added;
+    unsigned long updated;
+    unsigned long full; // Members dropped because the table was full
+};
+
+// Function to take a parsed member while only validating a roster
+static void skipRosterRecord(const RosterRecord &record, void *context)
+{
+}
+
+// Serial import in progress, validated as it is spooled
+static RosterParser serialParser(skipRosterRecord, NULL);
+static halFile serialSpool;
+static bool serialSpooled = false; // Spool open and every write to it succeeded
+static bool serialImporting = false;
+static unsigned long serialLastByteAt = 0;
+
+// Function to start a batch
+static void beginRoster(rosterBatch &batch)
+{
+    batch.firstNew = uidCount;
+    batch.added = 0;
+    batch.updated = 0;
+    batch.full = 0;
+}
+
+// Function to apply one parsed member to the member table
+static void applyRosterRecord(const RosterRecord &record, void *context)
+{
+    rosterBatch &batch = *(rosterBatch *)context;
+
+    // Only members from before the batch are indexed; duplicates among the new ones are
+    // merged when the index is rebuilt
+    int index = memberIndex.find(record.uid);
+    if (index >= 0)
+    {
+        batch.updated++;
+    }
+    else if (uidCount < MAX_UIDS)
+    {
+        index = uidCount++;
+        memberUids[index] = record.uid;
+        bitsetAssign(memberLoggedBits, index, false);
+        details_db[index].lastLogTime = 0;
+        details_db[index].lastTimeSpent = 0;
+        memset(&details_db[index].stats, 0, sizeof(details_db[index].stats));
+        batch.added++;
+    }
+    else
+    {
+        batch.full++;
+        return;
+    }
+
+    bitsetAssign(memberAccessBits, index, record.hasAccess);
+    memcpy(details_db[index].name, record.name, sizeof(details_db[index].name));
+}
+
+// Function to index the members the batch appended. A UID that appears more than once
+// keeps its first slot and takes the details of its last occurrence.
+static void indexNewMembers(rosterBatch &batch)
+{
+    int kept = batch.firstNew;
+    for (int i = batch.firstNew; i < uidCount; i++)
+    {
+        if (i != kept)
+        {
+            memberUids[kept] = memberUids[i];
+            bitsetAssign(memberAccessBits, kept, memberHasAccess(i));
+            bitsetAssign(memberLoggedBits, kept, false);
+            details_db[kept] = details_db[i];
+        }
+        if (memberIndex.insert(kept))
+        {
+            kept++;
+            continue;
+        }
+
+        int first = memberIndex.find(memberUids[kept]);
+        bitsetAssign(memberAccessBits, first, memberHasAccess(kept));
+        memcpy(details_db[first].name, details_db[kept].name, sizeof(details_db[first].name));
+        batch.added--;
+        batch.updated++;
+    }
+    uidCount = kept;
+}
+
+// Function to feed a roster file to `parser` from where the file is
+static void feedRosterFile(halFile &file, RosterParser &parser)
+{
+    uint8_t chunk[ROSTER_READ_CHUNK];
+    size_t read;
+    while (!parser.done() && (read = halFileRead(file, chunk, sizeof(chunk))) > 0)
+    {
+        parser.feed(chunk, read);
+    }
+}
+
+// Function to apply the validated roster at `path` to the member table, index the new
+// members and save the table. Returns false if the file no longer reads back valid, after
+// reloading the table from flash, which the batch has not written to yet.
+static bool applyRoster(const char *path, rosterBatch &batch)
+{
+    halFile file = halFileOpen(path, HAL_FILE_READ);
+    if (!halFileIsOpen(file))
+    {
+        return false;
+    }
+    beginRoster(batch);
+    RosterParser parser(applyRosterRecord, &batch);
+    feedRosterFile(file, parser);
+    halFileClose(file);
+
+    if (!parser.finish())
+    {
+        loadMembers();
+        buildMemberIndex();
+        return false;
+    }
+    indexNewMembers(batch);
+    saveMembers();
+    forgetDeniedCards(); // The roster may have granted access to denied cards
+    return true;
+}
+
+// Function to report the outcome of an import on serial and the LCD
+static void reportRoster(RosterParser &parser, const rosterBatch &batch, bool valid)
+{
+    if (!valid)
+    {
+        Serial.println("Roster: import failed, members unchanged");
+    }
+
+    Serial.print("Roster (");
+    Serial.print(parser.binary() ? "binary" : "CSV");
+    Serial.print("): ");
+    Serial.print(parser.records());
+    Serial.print(" records, ");
+    Serial.print(valid ? batch.added : 0);
+    Serial.print(" added, ");
+    Serial.print(valid ? batch.updated : 0);
+    Serial.print(" updated, ");
+    Serial.print(parser.rejected());
+    Serial.print(" bad lines, ");
+    Serial.print(valid ? batch.full : 0);
+    Serial.println(" over capacity");
+
+    char line[LCD_COLS + 1];
+    snprintf(line, sizeof(line), "+%lu ~%lu", valid ? batch.added : 0, valid ? batch.updated : 0);
+    startFeedback();
+    addFeedbackScreen(valid ? "Roster loaded" : "Roster failed", line, 2000);
+}
+
+// Function to import the roster in the flash file at `path`, if there is one.
+// A file that was imported is renamed to ROSTER_DONE_PATH so it is not applied again
+// on the next boot (and does not undo changes made from the admin menu since).
+bool importRosterFile(const char *path)
+{
+    halFile file = halFileOpen(path, HAL_FILE_READ);
+    if (!halFileIsOpen(file))
+    {
+        return false;
+    }
+    RosterParser check(skipRosterRecord, NULL);
+    feedRosterFile(file, check);
+    halFileClose(file);
+
+    rosterBatch batch = {uidCount, 0, 0, 0};
+    bool valid = check.finish() && applyRoster(path, batch);
+    reportRoster(check, batch, valid);
+    if (valid)
+    {
+        halFileReplace(path, ROSTER_DONE_PATH);
+    }
+    return valid;
+}
+
+// Function to start importing a roster arriving on serial, called by the console's
+// "roster" command. The roster closes itself (an "end" line or the end of a binary
+// image); ROSTER_SERIAL_TIMEOUT_MS without a byte aborts the import.
+void startRosterSerial()
+{
+    serialParser = RosterParser(skipRosterRecord, NULL);
+    serialSpool = halFileOpen(ROSTER_SPOOL_PATH, HAL_FILE_CREATE);
+    serialSpooled = halFileIsOpen(serialSpool);
+    if (!serialSpooled)
+    {
+        Serial.println("Roster: cannot spool to flash, the import will fail");
+    }
+    serialImporting = true;
+    serialLastByteAt = millis();
+
+    startFeedback();
+    addFeedbackScreen("Loading roster..", "", ROSTER_SERIAL_TIMEOUT_MS);
+}
+
+// Function to tell whether a serial import is in progress
+bool rosterImportActive()
+{
+    return serialImporting;
+}
+
+// Function to end a serial import, applying the spooled roster if it arrived whole and valid
+static void finishRosterSerial(bool complete)
+{
+    serialImporting = false;
+    if (halFileIsOpen(serialSpool))
+    {
+        halFileClose(serialSpool);
+        serialSpool = halFile();
+    }
+
+    rosterBatch batch = {uidCount, 0, 0, 0};
+    bool valid = serialParser.finish() && complete && serialSpooled && applyRoster(ROSTER_SPOOL_PATH, batch);
+    reportRoster(serialParser, batch, valid);
+}
+
+// Function to spool and validate the roster bytes that have arrived since the last call,
+// called on every loop() pass while an import is in progress
+void pollRosterSerial()
+{
+    uint8_t chunk[ROSTER_READ_CHUNK];
+    size_t read = 0;
+    while (read < sizeof(chunk) && Serial.available() > 0)
+    {
+        chunk[read++] = Serial.read();
+    }
+    if (read > 0)
+    {
+        serialSpooled = serialSpooled && halFileWrite(serialSpool, chunk, read) == read;
+        serialParser.feed(chunk, read);
+        serialLastByteAt = millis();
+    }
+
+    if (serialParser.done())
+    {
+        finishRosterSerial(true);
+    }
+    else if (millis() - serialLastByteAt >= ROSTER_SERIAL_TIMEOUT_MS)
+    {
+        Serial.println("Roster: serial timeout");
+        finishRosterSerial(false);
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef SCANNER_CONFIG_HPP
+#define SCANNER_CONFIG_HPP
+
+#include <member_index.hpp>
+
+// Compile-time scanner configuration.
+// A deployment is one configuration struct of static constexpr members: member table
+// capacity, LCD geometry and joystick thresholds. Scanner<> checks it with static_asserts
+// and adds what follows from it, such as the member index type and the admin menu page
+// counts, and the firmware sizes its static tables and bounds its menus from the result.
+// A small door and a large site therefore each get storage sized exactly for them, and a
+// configuration that cannot work fails to compile instead of being checked at run time.
+// Pick one with -DSCANNER_CONFIG=SmallScanner; StandardScanner is the default.
+
+// A 16x2 LCD and up to 1024 members
+struct StandardScanner
+{
+    static constexpr int maxMembers = 1024;
+    static constexpr int indexSlots = 2048; // Hash index slots, power of two and at least 2 * maxMembers
+    static constexpr int lcdCols = 16;
+    static constexpr int lcdRows = 2;
+    static constexpr uint8_t lcdAddress = 0x27; // PCF8574 expander address
+    static constexpr int joystickLow = 500;     // Axis readings below this push left or down
+    static constexpr int joystickHigh = 3500;   // and above this right or up
+    static constexpr int joystickHysteresis = 500; // How far back towards the centre a pushed axis must return
+};
+
+// A single room with a short member list
+struct SmallScanner : StandardScanner
+{
+    static constexpr int maxMembers = 128;
+    static constexpr int indexSlots = 256;
+};
+
+// A large site with a 20x4 LCD, about as many members as the ESP32's RAM holds
+struct LargeScanner : StandardScanner
+{
+    static constexpr int maxMembers = 2048;
+    static constexpr int indexSlots = 4096;
+    static constexpr int lcdCols = 20;
+    static constexpr int lcdRows = 4;
+};
+
+template <class Config>
+struct Scanner : Config
+{
+    static_assert(Config::maxMembers > 0, "maxMembers must be positive");
+    static_assert(Config::indexSlots > 0 && (Config::indexSlots & (Config::indexSlots - 1)) == 0,
+                  "indexSlots must be a power of two");
+    static_assert(Config::indexSlots >= 2 * Config::maxMembers, "indexSlots must be at least 2 * maxMembers");
+    static_assert(Config::lcdRows >= 2 && Config::lcdRows <= 4, "screens need 2 to 4 LCD rows");
+    static_assert(Config::lcdCols >= 16 && Config::lcdCols <= (Config::lcdRows == 2 ? 40 : 20),
+                  "screens need 16 LCD columns, and the HD44780 has at most 80 cells");
+    static_assert(Config::joystickLow + Config::joystickHysteresis < Config::joystickHigh - Config::joystickHysteresis,
+                  "joystick release points must not overlap");
+
+    typedef MemberIndex<Config::indexSlots> Index;
+
+    static constexpr int mainMenuPages = 5;   // Members, add access, remove access, total, occupancy
+    static constexpr int detailPages = 8;     // UID, logged, last access, last time, week, month, average, range
+    static constexpr int occupancyPages = 24; // One per hour of the day
+};
+
+#ifndef SCANNER_CONFIG
+#define SCANNER_CONFIG StandardScanner
+#endif
+
+typedef Scanner<SCANNER_CONFIG> BadgeScanner;
+
+#endif // SCANNER_CONFIG_HPP
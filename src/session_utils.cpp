@@ -0,0 +1,101 @@
+#include <utils.hpp>
+
+// Session statistics.
+// The device keeps no session history. Each member instead carries a fixed set of running
+// aggregates (sessionStats, 32 bytes stored with the member record) that every exit folds
+// one more session into: this week's and this month's time and visit count, the number of
+// sessions since enrolment, a moving average and the shortest and longest session.
+
+// Function to number the week `time` falls in, counting Monday-to-Sunday weeks from
+// 2000-01-03 (2000-01-01 was a Saturday)
+static uint16_t weekOf(const RtcDateTime &time)
+{
+    return (toEpochTime(time) / SECONDS_PER_DAY + 5) / 7;
+}
+
+// Function to number the month `time` falls in, counting from January 2000
+static uint16_t monthOf(const RtcDateTime &time)
+{
+    return (time.Year() - 2000) * 12 + time.Month() - 1;
+}
+
+// Function to fold a session of `seconds` that ended at `end` into a member's statistics
+void recordSession(int index, const RtcDateTime &end, int seconds)
+{
+    sessionStats &stats = details_db[index].stats;
+    uint32_t length = seconds > 0 ? seconds : 0;
+
+    uint16_t week = weekOf(end);
+    if (stats.week != week)
+    {
+        stats.week = week;
+        stats.weekSessions = 0;
+        stats.weekSeconds = 0;
+    }
+    uint16_t month = monthOf(end);
+    if (stats.month != month)
+    {
+        stats.month = month;
+        stats.monthSessions = 0;
+        stats.monthSeconds = 0;
+    }
+    stats.weekSessions++;
+    stats.weekSeconds += length;
+    stats.monthSessions++;
+    stats.monthSeconds += length;
+
+    if (stats.sessions == 0)
+    {
+        stats.averageSeconds = length;
+        stats.minSeconds = length;
+        stats.maxSeconds = length;
+    }
+    else
+    {
+        int64_t delta = (int64_t)length - stats.averageSeconds;
+        stats.averageSeconds += delta / SESSION_EWMA_WEIGHT;
+        stats.minSeconds = min(stats.minSeconds, length);
+        stats.maxSeconds = max(stats.maxSeconds, length);
+    }
+    stats.sessions++;
+}
+
+// Function to return a member's statistics as of `now`: totals of a week or month that has
+// passed without a session read as zero
+sessionStats currentSessionStats(int index, const RtcDateTime &now)
+{
+    sessionStats stats = details_db[index].stats;
+    if (stats.week != weekOf(now))
+    {
+        stats.weekSessions = 0;
+        stats.weekSeconds = 0;
+    }
+    if (stats.month != monthOf(now))
+    {
+        stats.monthSessions = 0;
+        stats.monthSeconds = 0;
+    }
+    return stats;
+}
+
+// Function to format a duration as hours and minutes, e.g. "12h05m"
+char *formatDuration(uint32_t seconds, char *out, size_t size)
+{
+    snprintf(out, size, "%luh%02lum", (unsigned long)(seconds / 3600), (unsigned long)(seconds % 3600 / 60));
+    return out;
+}
+
+// Function to print a member's session statistics on serial
+void printSessionStats(int index, const RtcDateTime &now)
+{
+    sessionStats stats = currentSessionStats(index, now);
+    char week[12], month[12], average[12], shortest[12], longest[12];
+    char line[160];
+    snprintf(line, sizeof(line), "Sessions of %s: week %u (%s), month %u (%s), total %lu, avg %s, min %s, max %s",
+             details_db[index].name, stats.weekSessions, formatDuration(stats.weekSeconds, week, sizeof(week)),
+             stats.monthSessions, formatDuration(stats.monthSeconds, month, sizeof(month)),
+             (unsigned long)stats.sessions, formatDuration(stats.averageSeconds, average, sizeof(average)),
+             formatDuration(stats.minSeconds, shortest, sizeof(shortest)),
+             formatDuration(stats.maxSeconds, longest, sizeof(longest)));
+    Serial.println(line);
+}
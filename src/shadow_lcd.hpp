@@ -0,0 +1,52 @@
+#ifndef SHADOW_LCD_HPP
+#define SHADOW_LCD_HPP
+
+#include <LiquidCrystal_I2C.h>
+#include <Wire.h>
+
+// Shadow framebuffer in front of the HD44780.
+// It offers the same clear()/setCursor()/print() calls as LiquidCrystal_I2C, but they
+// only change a RAM copy of the screen. refresh() compares that copy with what the
+// display currently shows and sends just the cells that differ, packing each run of
+// changed cells into a single I2C transaction. clear() never sends the slow (~2 ms)
+// clear command; blanked cells are simply diffed like any other change.
+class ShadowLCD : public Print
+{
+public:
+    ShadowLCD(LiquidCrystal_I2C &device, uint8_t address);
+
+    void init();
+    void backlight();
+
+    void clear();
+    void setCursor(uint8_t col, uint8_t row);
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+    // Function to push pending changes to the display
+    void refresh();
+
+    // Traffic counters, for checking what the diffing saves
+    unsigned long i2cBytes() const { return bytesSent; }
+    unsigned long i2cTransactions() const { return transactions; }
+
+private:
+    void beginTransfer();
+    void sendByte(uint8_t value, bool isData);
+    void endTransfer();
+    void sendRun(uint8_t row, uint8_t first, uint8_t last);
+
+    LiquidCrystal_I2C &device;
+    uint8_t address;
+    char wanted[LCD_ROWS][LCD_COLS]; // What the screen should show
+    char shown[LCD_ROWS][LCD_COLS];  // What the display currently shows
+    uint8_t cursorCol;
+    uint8_t cursorRow;
+    int deviceCol; // Display's own cursor position, -1 if unknown
+    int deviceRow;
+    uint8_t pending; // Bytes in the open I2C transaction
+    unsigned long bytesSent;
+    unsigned long transactions;
+};
+
+#endif // SHADOW_LCD_HPP
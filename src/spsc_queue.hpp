@@ -0,0 +1,57 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <stddef.h>
+#include <atomic>
+
+// Fixed-capacity lock-free queue for exactly one producer and one consumer, which may run
+// on different cores. The producer only writes `tail` and the consumer only writes
+// `head`; each publishes its slot with a release store that the other side reads with
+// an acquire load, so no lock or critical section is needed. CAPACITY must be a power
+// of two; the counters run freely and are masked into the slot array.
+template <typename T, size_t CAPACITY>
+class SpscQueue
+{
+    static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    // Producer side. Returns false, leaving the queue unchanged, if it is full.
+    bool push(const T &item)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == CAPACITY)
+        {
+            return false;
+        }
+        items[t & (CAPACITY - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if the queue is empty.
+    bool pop(T &item)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        item = items[h & (CAPACITY - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Drops everything queued so far.
+    void clear() { head.store(tail.load(std::memory_order_acquire), std::memory_order_release); }
+
+    size_t size() const { return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire); }
+
+private:
+    T items[CAPACITY];
+    std::atomic<size_t> head; // Next item to pop, written only by the consumer
+    std::atomic<size_t> tail; // Next free slot, written only by the producer
+};
+
+#endif // SPSC_QUEUE_HPP
@@ -0,0 +1,469 @@
+#include <utils.hpp>
+#include <crc.hpp>
+
+// Persistent member table.
+// The members are kept in a snapshot file: a small header followed by one fixed-size
+// record per member, in member table order. A member that changes is not rewritten in
+// place, which on LittleFS would copy the whole tail of the snapshot; its new record is
+// appended to a journal instead, so each scan or admin action costs one small append.
+// Records carry their UID, so boot reads the snapshot front to back in one pass and then
+// replays the journal over it, later records replacing earlier ones and unknown UIDs
+// enrolling new members. Once the journal holds STORE_JOURNAL_MAX records it is compacted:
+// the whole table is written as a new snapshot and the journal emptied. A power cut
+// between the two only leaves records behind that the new snapshot already holds.
+//
+// On the ESP32 the file lives on LittleFS. Host builds go through the same HAL file calls
+// onto an ordinary file, so the same code can be exercised on Linux.
+// Records hold UIDs and names in clear: sealing each one would cost a nonce and a tag per
+// journal append, so on a deployed board protect the partition with the ESP32's flash
+// encryption instead.
+
+#define STORE_PATH "/members.bin"
+#define STORE_TEMP_PATH "/members.tmp"
+#define STORE_JOURNAL_PATH "/members.log"
+
+#define STORE_MAGIC 0x53474442 // "BDGS"
+#define STORE_VERSION 3
+#define STORE_CHUNK 16       // Records read per file access while loading
+#define STORE_JOURNAL_MAX 64 // Journal records that trigger a compaction (~5 KB)
+
+// Snapshot header, protected by its own CRC
+struct storeHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t count;
+    uint32_t crc; // CRC-32 of the fields above
+};
+
+// On-flash member record. Every record carries its own CRC so it can be rewritten alone.
+struct storedMember
+{
+    uint8_t uid[UID_MAX_BYTES];
+    uint8_t uidSize;
+    uint8_t flags; // STORED_HAS_ACCESS | STORED_LOGGED
+    uint32_t lastLogTime; // EpochTime
+    int32_t lastTimeSpent;
+    char name[STORED_NAME_SIZE];
+    sessionStats stats;
+    uint32_t crc; // CRC-32 of the fields above
+};
+
+// Version 2 record, from before the session statistics. Only read to migrate old snapshots.
+struct storedMemberV2
+{
+    uint8_t uid[UID_MAX_BYTES];
+    uint8_t uidSize;
+    uint8_t flags;
+    uint32_t lastLogTime;
+    int32_t lastTimeSpent;
+    char name[STORED_NAME_SIZE];
+    uint32_t crc;
+};
+
+// Version 1 record, which kept the last log time as seconds of the year plus a
+// "MM/DD/YYYY HH:MM:SS" string. Only read to migrate old snapshots.
+struct storedMemberV1
+{
+    uint8_t uid[UID_MAX_BYTES];
+    uint8_t uidSize;
+    uint8_t flags;
+    int32_t lastLogTimeInt;
+    int32_t lastTimeSpent;
+    char name[STORED_NAME_SIZE];
+    char lastLogTime[20];
+    uint32_t crc;
+};
+
+#define STORED_HAS_ACCESS 0x01
+#define STORED_LOGGED 0x02
+
+static_assert(sizeof(storeHeader) == 16, "storeHeader layout changed");
+static_assert(sizeof(sessionStats) == 32, "sessionStats layout changed");
+static_assert(sizeof(storedMember) == 80, "storedMember layout changed");
+static_assert(sizeof(storedMemberV2) == 48, "storedMemberV2 layout changed");
+static_assert(sizeof(storedMemberV1) == 68, "storedMemberV1 layout changed");
+
+static bool storeReady = false;    // Filesystem mounted
+static uint32_t journalCount = 0;  // Records appended to the journal since the last snapshot
+static storedMember storeBuffer[STORE_CHUNK];
+
+// --- Record conversion ---
+
+// Function to fill a header for the given number of records
+static void makeHeader(storeHeader &header, uint32_t count)
+{
+    header.magic = STORE_MAGIC;
+    header.version = STORE_VERSION;
+    header.recordSize = sizeof(storedMember);
+    header.count = count;
+    header.crc = crc32(&header, offsetof(storeHeader, crc));
+}
+
+// Function to encode a member into its on-flash record
+static void encodeMember(int index, storedMember &record)
+{
+    const memberDetails &details = details_db[index];
+    memset(&record, 0, sizeof(record));
+    memcpy(record.uid, memberUids[index].bytes, UID_MAX_BYTES);
+    record.uidSize = memberUids[index].size;
+    record.flags = (memberHasAccess(index) ? STORED_HAS_ACCESS : 0) | (memberLogged(index) ? STORED_LOGGED : 0);
+    record.lastLogTime = details.lastLogTime;
+    record.lastTimeSpent = details.lastTimeSpent;
+    memcpy(record.name, details.name, sizeof(record.name));
+    record.stats = details.stats;
+    record.crc = crc32(&record, offsetof(storedMember, crc));
+}
+
+// Function to decode a record into member slot `index`. Returns false if the record is corrupt.
+static bool decodeMember(storedMember &record, int index)
+{
+    if (record.crc != crc32(&record, offsetof(storedMember, crc)) || record.uidSize == 0 ||
+        record.uidSize > UID_MAX_BYTES)
+    {
+        return false;
+    }
+
+    // Terminate the name in case the record was written by a different build
+    record.name[sizeof(record.name) - 1] = '\0';
+
+    memberDetails &details = details_db[index];
+    memcpy(memberUids[index].bytes, record.uid, UID_MAX_BYTES);
+    memberUids[index].size = record.uidSize;
+    bitsetAssign(memberAccessBits, index, record.flags & STORED_HAS_ACCESS);
+    bitsetAssign(memberLoggedBits, index, record.flags & STORED_LOGGED);
+    details.lastLogTime = record.lastLogTime;
+    details.lastTimeSpent = record.lastTimeSpent;
+    memcpy(details.name, record.name, sizeof(details.name));
+    details.stats = record.stats;
+    return true;
+}
+
+// Function to convert a version 2 record to the current layout, with no session
+// statistics yet. Returns false if the old record is corrupt.
+static bool upgradeMemberV2(const storedMemberV2 &old, storedMember &record)
+{
+    if (old.crc != crc32(&old, offsetof(storedMemberV2, crc)))
+    {
+        return false;
+    }
+
+    memset(&record, 0, sizeof(record));
+    memcpy(record.uid, old.uid, UID_MAX_BYTES);
+    record.uidSize = old.uidSize;
+    record.flags = old.flags;
+    record.lastLogTime = old.lastLogTime;
+    record.lastTimeSpent = old.lastTimeSpent;
+    memcpy(record.name, old.name, sizeof(record.name));
+    record.crc = crc32(&record, offsetof(storedMember, crc));
+    return true;
+}
+
+// Function to convert a version 1 record to the current layout.
+// The epoch time is recovered from the "MM/DD/YYYY HH:MM:SS" string. Returns false if the
+// old record is corrupt.
+static bool upgradeMemberV1(storedMemberV1 &old, storedMember &record)
+{
+    if (old.crc != crc32(&old, offsetof(storedMemberV1, crc)))
+    {
+        return false;
+    }
+
+    unsigned month, day, year, hour, minute, second;
+    old.lastLogTime[sizeof(old.lastLogTime) - 1] = '\0';
+    EpochTime lastLogTime = 0;
+    if (sscanf(old.lastLogTime, "%u/%u/%u %u:%u:%u", &month, &day, &year, &hour, &minute, &second) == 6)
+    {
+        lastLogTime = toEpochTime(RtcDateTime(year, month, day, hour, minute, second));
+    }
+
+    memset(&record, 0, sizeof(record));
+    memcpy(record.uid, old.uid, UID_MAX_BYTES);
+    record.uidSize = old.uidSize;
+    record.flags = old.flags;
+    record.lastLogTime = lastLogTime;
+    record.lastTimeSpent = old.lastTimeSpent;
+    memcpy(record.name, old.name, sizeof(record.name));
+    record.crc = crc32(&record, offsetof(storedMember, crc));
+    return true;
+}
+
+// Function to read one record of an old snapshot and convert it to the current layout.
+// A corrupt record comes back all-zero. Returns false at the end of the file.
+static bool readLegacyMember(halFile file, uint16_t version, storedMember &record)
+{
+    bool valid;
+    if (version == 1)
+    {
+        storedMemberV1 old;
+        if (halFileRead(file, &old, sizeof(old)) != sizeof(old))
+        {
+            return false;
+        }
+        valid = upgradeMemberV1(old, record);
+    }
+    else
+    {
+        storedMemberV2 old;
+        if (halFileRead(file, &old, sizeof(old)) != sizeof(old))
+        {
+            return false;
+        }
+        valid = upgradeMemberV2(old, record);
+    }
+
+    if (!valid)
+    {
+        memset(&record, 0, sizeof(record));
+    }
+    return true;
+}
+
+// --- Public functions ---
+
+// Function to write the whole member table as a fresh snapshot.
+// The snapshot is written to a temporary file first and then renamed over the old one,
+// so a power cut never leaves a half-written table behind.
+bool saveMembers()
+{
+    if (!storeReady)
+    {
+        return false;
+    }
+
+    halFile file = halFileOpen(STORE_TEMP_PATH, HAL_FILE_CREATE);
+    if (!halFileIsOpen(file))
+    {
+        Serial.println("Member store: cannot create snapshot");
+        return false;
+    }
+
+    storeHeader header;
+    makeHeader(header, uidCount);
+    bool ok = halFileWrite(file, &header, sizeof(header)) == sizeof(header);
+
+    // Encode and write the records a chunk at a time
+    for (int first = 0; ok && first < uidCount; first += STORE_CHUNK)
+    {
+        int chunk = min(STORE_CHUNK, uidCount - first);
+        for (int i = 0; i < chunk; i++)
+        {
+            encodeMember(first + i, storeBuffer[i]);
+        }
+        size_t bytes = chunk * sizeof(storedMember);
+        ok = halFileWrite(file, storeBuffer, bytes) == bytes;
+    }
+    halFileClose(file);
+
+    if (!ok || !halFileReplace(STORE_TEMP_PATH, STORE_PATH))
+    {
+        Serial.println("Member store: snapshot write failed");
+        return false;
+    }
+
+    // The snapshot now holds every journal record, so start the journal over
+    file = halFileOpen(STORE_JOURNAL_PATH, HAL_FILE_CREATE);
+    if (halFileIsOpen(file))
+    {
+        halFileClose(file);
+    }
+    journalCount = 0;
+    return true;
+}
+
+// Function to apply the journal to the member table just loaded from the snapshot.
+// Returns the number of records that were corrupt. A record cut short by a power cut ends
+// the journal and counts as corrupt, so the caller compacts it before the next append
+// would land after the partial bytes and misalign every record from there on.
+static int replayJournal()
+{
+    journalCount = 0;
+    halFile file = halFileOpen(STORE_JOURNAL_PATH, HAL_FILE_READ);
+    if (!halFileIsOpen(file))
+    {
+        return 0;
+    }
+
+    int corrupt = 0;
+    storedMember &record = storeBuffer[0];
+    size_t read;
+    while ((read = halFileRead(file, &record, sizeof(record))) == sizeof(record))
+    {
+        journalCount++;
+        if (record.uidSize == 0 || record.uidSize > UID_MAX_BYTES)
+        {
+            corrupt++;
+            continue;
+        }
+
+        // The member table is not indexed yet, so look the UID up directly
+        CardUid uid;
+        memcpy(uid.bytes, record.uid, UID_MAX_BYTES);
+        uid.size = record.uidSize;
+        int index = 0;
+        while (index < uidCount && !(memberUids[index] == uid))
+        {
+            index++;
+        }
+        if (index == MAX_UIDS || !decodeMember(record, index))
+        {
+            corrupt++;
+        }
+        else if (index == uidCount)
+        {
+            uidCount++; // Enrolled after the snapshot was taken
+        }
+    }
+    halFileClose(file);
+    if (read != 0)
+    {
+        corrupt++; // Partial record at the end
+    }
+    return corrupt;
+}
+
+// Function to load the member table from the snapshot in a single pass.
+// If there is no valid snapshot yet, the built-in members are kept and saved as the
+// first snapshot. Returns true if members were loaded from flash.
+bool loadMembers()
+{
+    storeReady = halFsMount();
+    if (!storeReady)
+    {
+        Serial.println("Member store: filesystem unavailable, changes will not persist");
+        return false;
+    }
+
+    halFile file = halFileOpen(STORE_PATH, HAL_FILE_READ);
+    if (!halFileIsOpen(file))
+    {
+        Serial.println("Member store: no snapshot, saving built-in members");
+        saveMembers();
+        return false;
+    }
+
+    storeHeader header;
+    memset(&header, 0, sizeof(header));
+    if (halFileRead(file, &header, sizeof(header)) != sizeof(header))
+    {
+        header.magic = 0; // Too short to hold a header
+    }
+    if (header.magic != STORE_MAGIC || header.crc != crc32(&header, offsetof(storeHeader, crc)))
+    {
+        halFileClose(file);
+        Serial.println("Member store: snapshot invalid, saving built-in members");
+        saveMembers();
+        return false;
+    }
+
+    // A sound snapshot this build cannot read, written by a newer firmware or for more
+    // members than this configuration holds, is real data: leave it for the build that
+    // wrote it and keep this boot's changes off the flash
+    bool legacy = (header.version == 1 && header.recordSize == sizeof(storedMemberV1)) ||
+                  (header.version == 2 && header.recordSize == sizeof(storedMemberV2));
+    bool current = header.version == STORE_VERSION && header.recordSize == sizeof(storedMember);
+    if ((!legacy && !current) || header.count > MAX_UIDS)
+    {
+        halFileClose(file);
+        Serial.print("Member store: snapshot version ");
+        Serial.print(header.version);
+        Serial.print(" with ");
+        Serial.print(header.count);
+        Serial.println(" members cannot be loaded, changes will not persist");
+        storeReady = false;
+        return false;
+    }
+
+    // Read the records in chunks and decode them straight into the member table
+    int loaded = 0;
+    int corrupt = 0;
+    for (uint32_t first = 0; first < header.count; first += STORE_CHUNK)
+    {
+        uint32_t chunk = min((uint32_t)STORE_CHUNK, header.count - first);
+        size_t read = 0;
+        if (!legacy)
+        {
+            read = halFileRead(file, storeBuffer, chunk * sizeof(storedMember)) / sizeof(storedMember);
+        }
+        else
+        {
+            // Old snapshots are converted record by record; corrupt ones become all-zero and are skipped below
+            while (read < chunk && readLegacyMember(file, header.version, storeBuffer[read]))
+            {
+                read++;
+            }
+        }
+
+        for (size_t i = 0; i < read; i++)
+        {
+            if (decodeMember(storeBuffer[i], loaded))
+            {
+                loaded++;
+            }
+            else
+            {
+                corrupt++;
+            }
+        }
+        if (read < chunk)
+        {
+            corrupt += header.count - first - read; // Truncated file
+            break;
+        }
+    }
+    halFileClose(file);
+
+    uidCount = loaded;
+    corrupt += replayJournal();
+    Serial.print("Member store: loaded ");
+    Serial.print(uidCount);
+    Serial.print(" members, ");
+    Serial.print(journalCount);
+    Serial.println(" journal records");
+
+    // Dropped records shift the positions of the ones after them, so rewrite the file.
+    // Old snapshots are rewritten in the current layout.
+    if (corrupt > 0)
+    {
+        Serial.print("Member store: skipped corrupt records: ");
+        Serial.println(corrupt);
+    }
+    if (corrupt > 0 || legacy || journalCount >= STORE_JOURNAL_MAX)
+    {
+        saveMembers();
+    }
+    return true;
+}
+
+// Function to persist a single member after it changed.
+// Appends the member's record to the journal, compacting it into a new snapshot once it is full.
+void storeMember(int index)
+{
+    if (!storeReady || index < 0 || index >= uidCount)
+    {
+        return;
+    }
+
+    halFile file = halFileOpen(STORE_JOURNAL_PATH, HAL_FILE_APPEND);
+    if (!halFileIsOpen(file))
+    {
+        saveMembers();
+        return;
+    }
+
+    storedMember record;
+    encodeMember(index, record);
+    bool ok = halFileWrite(file, &record, sizeof(record)) == sizeof(record);
+    halFileClose(file);
+
+    if (!ok)
+    {
+        Serial.println("Member store: journal write failed");
+        saveMembers();
+    }
+    else if (++journalCount >= STORE_JOURNAL_MAX)
+    {
+        saveMembers();
+    }
+}
@@ -1,26 +1,178 @@
-
-#include "utils.hpp"
-
-void get_temperature_humidity(float &temperature, float &humidity)
-{
-    // Read temperature as Celsius
-    temperature = dht.readTemperature();
-    // Read humidity
-    humidity = dht.readHumidity();
-
-    // Check if the readings are valid
-    if (isnan(temperature) || isnan(humidity))
-    {
-        Serial.println("Failed to read from DHT sensor!");
-        return;
-    }
-
-    // Print temperature and humidity
-    Serial.print("Temperature: ");
-    Serial.print(temperature);
-    Serial.println(" °C");
-
-    Serial.print("Humidity: ");
-    Serial.print(humidity);
-    Serial.println(" %");
-}
+#include "utils.hpp"
+#include <spsc_queue.hpp>
+
+// DHT sampler.
+// The DHT11 takes ~25 ms per read and gives a fresh value at most every couple of
+// seconds, so it is sampled by a background task instead of on every entry and exit.
+// The task keeps a ring of the last CLIMATE_WINDOW_SAMPLES valid readings, works out the
+// window's minimum, maximum and mean after each sample and hands loop() a complete
+// snapshot through a lock-free queue. loop() keeps the newest snapshot, so the scan path
+// reads the climate in O(1) and never waits on the sensor bus.
+
+// Readings are kept in tenths of a degree / percent to halve the ring's size
+struct climateSample
+{
+    int16_t temperature;
+    int16_t humidity;
+};
+
+// Sampler state, only touched by the sampler task
+static climateSample climateWindow[CLIMATE_WINDOW_SAMPLES];
+static int climateSamples = 0;             // Valid samples in the window
+static int climateNext = 0;                // Ring slot the next sample goes into
+static long temperatureSum = 0;            // Sums over the window, in tenths
+static long humiditySum = 0;
+static ClimateReading sampled = {NAN, NAN, 0, {NAN, NAN, NAN}, {NAN, NAN, NAN}, 0, 0};
+static bool sensorFailing = false;
+
+// Snapshots on their way from the sampler task to loop(), and the newest one received
+static SpscQueue<ClimateReading, 4> climateQueue;
+static ClimateReading climate = {NAN, NAN, 0, {NAN, NAN, NAN}, {NAN, NAN, NAN}, 0, 0};
+
+// Function to work out min, max and mean of one field of the window
+static ClimateStats windowStats(int16_t climateSample::*field, long sum)
+{
+    int16_t low = climateWindow[0].*field;
+    int16_t high = low;
+    for (int i = 1; i < climateSamples; i++)
+    {
+        int16_t value = climateWindow[i].*field;
+        low = value < low ? value : low;
+        high = value > high ? value : high;
+    }
+    ClimateStats stats;
+    stats.min = low / 10.0f;
+    stats.max = high / 10.0f;
+    stats.mean = sum / 10.0f / climateSamples;
+    return stats;
+}
+
+// Function to add a valid reading to the window, dropping the oldest once it is full
+static void addToWindow(float temperature, float humidity)
+{
+    climateSample sample;
+    sample.temperature = (int16_t)lroundf(temperature * 10);
+    sample.humidity = (int16_t)lroundf(humidity * 10);
+
+    climateSample &slot = climateWindow[climateNext];
+    if (climateSamples == CLIMATE_WINDOW_SAMPLES)
+    {
+        temperatureSum -= slot.temperature;
+        humiditySum -= slot.humidity;
+    }
+    else
+    {
+        climateSamples++;
+    }
+    slot = sample;
+    temperatureSum += sample.temperature;
+    humiditySum += sample.humidity;
+    climateNext = (climateNext + 1) % CLIMATE_WINDOW_SAMPLES;
+}
+
+// Function to take one reading and publish a new snapshot, run over and over by the
+// sampler task
+static void sampleClimate()
+{
+    float temperature = dht.readTemperature();
+    float humidity = dht.readHumidity();
+
+    if (isnan(temperature) || isnan(humidity))
+    {
+        sampled.failures++;
+        if (!sensorFailing)
+        {
+            Serial.println("Failed to read from DHT sensor!");
+        }
+        sensorFailing = true;
+    }
+    else
+    {
+        sensorFailing = false;
+        addToWindow(temperature, humidity);
+        sampled.temperature = temperature;
+        sampled.humidity = humidity;
+        sampled.takenAt = millis();
+        sampled.temperatureStats = windowStats(&climateSample::temperature, temperatureSum);
+        sampled.humidityStats = windowStats(&climateSample::humidity, humiditySum);
+        sampled.samples = climateSamples;
+    }
+
+    // If loop() has fallen behind the snapshot is simply sent with the next sample
+    climateQueue.push(sampled);
+    delay(CLIMATE_SAMPLE_MS);
+}
+
+// Function to start sampling the DHT in the background, called once from setup()
+void startClimateSampler()
+{
+    halStartService("dht", sampleClimate, SENSOR_CORE);
+}
+
+// Function to take in the snapshots the sampler has published, called on every loop() pass
+void updateClimate()
+{
+    ClimateReading reading;
+    while (climateQueue.pop(reading))
+    {
+        climate = reading;
+    }
+}
+
+// Function to return the newest snapshot from the sampler
+const ClimateReading &currentClimate()
+{
+    return climate;
+}
+
+// Function to return the last valid reading, or NAN if it is older than CLIMATE_MAX_AGE_MS
+void get_temperature_humidity(float &temperature, float &humidity)
+{
+    if (climate.samples == 0 || (long)(millis() - climate.takenAt) > CLIMATE_MAX_AGE_MS)
+    {
+        temperature = NAN;
+        humidity = NAN;
+        Serial.println("No recent DHT reading");
+        return;
+    }
+    temperature = climate.temperature;
+    humidity = climate.humidity;
+
+    // Print temperature and humidity
+    Serial.print("Temperature: ");
+    Serial.print(temperature);
+    Serial.println(" °C");
+
+    Serial.print("Humidity: ");
+    Serial.print(humidity);
+    Serial.println(" %");
+}
+
+// Function to print the rolling window's statistics to serial
+void printClimateStats()
+{
+    if (climate.samples == 0)
+    {
+        return;
+    }
+    Serial.print("Climate over last ");
+    Serial.print(climate.samples * (CLIMATE_SAMPLE_MS / 1000));
+    Serial.print(" s: ");
+    Serial.print(climate.temperatureStats.min, 1);
+    Serial.print("/");
+    Serial.print(climate.temperatureStats.mean, 1);
+    Serial.print("/");
+    Serial.print(climate.temperatureStats.max, 1);
+    Serial.print(" C, ");
+    Serial.print(climate.humidityStats.min, 1);
+    Serial.print("/");
+    Serial.print(climate.humidityStats.mean, 1);
+    Serial.print("/");
+    Serial.print(climate.humidityStats.max, 1);
+    Serial.println(" % (min/mean/max)");
+    if (climate.failures > 0)
+    {
+        Serial.print("DHT read failures since boot: ");
+        Serial.println(climate.failures);
+    }
+}
@@ -1,15 +1,29 @@
-#include <utils.hpp>
-
-// Define global variables
-MFRC522 mfrc522(SS_PIN, RST_PIN);
-LiquidCrystal_I2C lcd(0x27, 16, 2);
-int uidCount = 3;
-int currentMemberIndex = 0;
-ThreeWire myWire(RTC_DAT_PIN, RTC_CLK_PIN, RTC_RST_PIN);
-RtcDS1302<ThreeWire> Rtc(myWire);
-DHT dht(DHTPIN, DHTTYPE);
-// Initialize the members database
-user users_db[MAX_UIDS] = {
-    {"E37A082F", "John Doe", "", 0, false, 0, false},
-    {"E3E40B2F", "Jane Smith", "", 0, true, 0, false},
-    {"50E5BF14", "Mary Johnson", "", 0, true, 0, false}};
+#include <utils.hpp>
+
+// Define global variables
+// RFID readers, polled in this order. A lone reader set to READER_TOGGLE works the way a
+// single-reader scanner does: each scan flips the member between in and out.
+ReaderConfig readerConfigs[MAX_READERS] = {
+    {SS_PIN, READER_ENTRY, "entry"},
+    {EXIT_SS_PIN, READER_EXIT, "exit"},
+};
+int readerCount = 2;
+LiquidCrystal_I2C lcdDevice(BadgeScanner::lcdAddress, LCD_COLS, LCD_ROWS);
+ShadowLCD lcd(lcdDevice, BadgeScanner::lcdAddress);
+int uidCount = 3;
+int currentMemberIndex = 0;
+ThreeWire myWire(RTC_DAT_PIN, RTC_CLK_PIN, RTC_RST_PIN);
+RtcDS1302<ThreeWire> Rtc(myWire);
+DHT dht(DHTPIN, DHTTYPE);
+// Initialize the members database
+CardUid memberUids[MAX_UIDS] = {
+    cardUidFromHex("E37A082F"),
+    cardUidFromHex("E3E40B2F"),
+    cardUidFromHex("50E5BF14")};
+uint32_t memberAccessBits[BITSET_WORDS(MAX_UIDS)] = {(1u << 1) | (1u << 2)}; // Jane and Mary have access
+uint32_t memberLoggedBits[BITSET_WORDS(MAX_UIDS)] = {0};
+memberDetails details_db[MAX_UIDS] = {
+    {"John Doe", 0, 0},
+    {"Jane Smith", 0, 0},
+    {"Mary Johnson", 0, 0}};
+BadgeScanner::Index memberIndex(memberUids);
\ No newline at end of file
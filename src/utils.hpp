@@ -1,113 +1,363 @@
-#ifndef UTILS_HPP
-#define UTILS_HPP
-
-#include <SPI.h>
-#include <MFRC522.h>
-#include <LiquidCrystal_I2C.h>
-#include <Wire.h>
-#include <RtcDS1302.h>
-#include <ThreeWire.h>
-#include <Adafruit_Sensor.h>
-#include <DHT.h>
-
-// Pin defines for ESP
-#define SCK_PIN 18
-#define MISO_PIN 19
-#define MOSI_PIN 23
-#define SS_PIN 21
-#define RST_PIN 22
-
-#define RED_PIN 17  // RGB LED Red
-#define GREEN_PIN 4 // RGB LED Green
-#define BLUE_PIN 2  // RGB LED Blue
-
-#define BUZZER_PIN 5 // Buzzer
-
-#define NOTE_C4 261
-#define NOTE_E4 329
-#define NOTE_G4 392
-#define NOTE_C5 523
-#define NOTE_E5 659
-#define NOTE_G5 784
-
-#define MAX_UIDS 10
-
-#define JOYSTICK_SW_PIN 34  // Joystick Switch
-#define JOYSTICK_URX_PIN 32 // Joystick URX
-#define JOYSTICK_URY_PIN 35 // Joystick URY
-
-#define RTC_CLK_PIN 33
-#define RTC_DAT_PIN 16
-#define RTC_RST_PIN 15
-
-#define LCD_SDA_PIN 25 // LCD SDA
-#define LCD_SCL_PIN 26 // LCD SCL
-
-#define ADMIN_UID "53F7CA0E"
-
-#define LOWER_JOYSTICK_THRESHOLD 500
-#define UPPER_JOYSTICK_THRESHOLD 3500
-
-#define DHTPIN 13     // Pin connected to the DHT11 sensor
-#define DHTTYPE DHT11 // Define the type of DHT sensor
-
-// Member struct
-struct user
-{
-    String uid;
-    String name;
-    String lastLogTime;
-    int lastLogTimeInt;
-    bool hasAccess;
-    int lastTimeSpent;
-    bool logged;
-};
-
-// Extern declarations for global variables
-extern MFRC522 mfrc522;
-extern LiquidCrystal_I2C lcd;
-extern user users_db[MAX_UIDS];
-extern int uidCount;
-extern int currentMemberIndex;
-extern ThreeWire myWire;
-extern RtcDS1302<ThreeWire> Rtc;
-extern DHT dht;
-
-// Function declarations
-int daysInMonth(int month, int year);
-int dateToInt(const RtcDateTime &dt);
-void printStringOnLCD(const char *message);
-String convertUID(MFRC522 &mfrc522);
-int uidToIndex(String uid);
-void addCardAccess();
-void removeCardAccess();
-void showTotalNumber();
-float calculateTimeSpentPercentage(int lastTimeSpent, int currentTimeSpent);
-String formatSpentTime(int totalSeconds);
-RtcDateTime readQuartzTime();
-void setDateTime();
-void displayExitTime(RtcDateTime now, int index);
-void printIdle();
-String timeToString(const RtcDateTime &dt);
-bool isAuthorizedUID(String uid);
-void turnOffLEDs();
-void goodbyeMelody();
-void adminGoodbyeMelody();
-void adminAccessMelody();
-void accessGrantedMelody();
-void accessDeniedMelody();
-void setupLEDControl();
-void get_temperature_humidity(float &temperature, float &humidity);
-void print_temperature_humidity(float temperature, float humidity);
-void printStringOnLCD(String message);
-void turnOffLedsAndBuzzer();
-void playMelody(int note, int duration, int delayP);
-String intToDate(int seconds);
-void updateReceived();
-void turnLedWhite();
-String encryptAES(const String &plaintext);
-String decryptAES(const String &ciphertext);
-void waitForJoystickUp();
-void printStringOnLCD(const char *message);
-
-#endif // UTILS_HPP
+#ifndef UTILS_HPP
+#define UTILS_HPP
+
+#include <hal.hpp>
+#include <card_uid.hpp>
+#include <member_index.hpp>
+#include <scanner_config.hpp>
+#include <latency.hpp>
+#include <atomic>
+
+// Pin defines for ESP
+#define SCK_PIN 18
+#define MISO_PIN 19
+#define MOSI_PIN 23
+#define SS_PIN 21      // Entry reader chip select
+#define EXIT_SS_PIN 27 // Exit reader chip select
+#define RST_PIN 22     // Reset, shared by the readers
+
+#define RED_PIN 17  // RGB LED Red
+#define GREEN_PIN 4 // RGB LED Green
+#define BLUE_PIN 2  // RGB LED Blue
+
+#define BUZZER_PIN 5 // Buzzer
+
+#define NOTE_C4 261
+#define NOTE_E4 329
+#define NOTE_G4 392
+#define NOTE_C5 523
+#define NOTE_E5 659
+#define NOTE_G5 784
+
+// Shorthands for the configured deployment (scanner_config.hpp)
+constexpr int MAX_UIDS = BadgeScanner::maxMembers;
+constexpr int LCD_COLS = BadgeScanner::lcdCols;
+constexpr int LCD_ROWS = BadgeScanner::lcdRows;
+
+#define STORED_NAME_SIZE 24      // Bytes kept for a member name, including the terminator
+
+#define JOYSTICK_SW_PIN 34  // Joystick Switch
+#define JOYSTICK_URX_PIN 32 // Joystick URX
+#define JOYSTICK_URY_PIN 35 // Joystick URY
+
+#define RTC_CLK_PIN 33
+#define RTC_DAT_PIN 16
+#define RTC_RST_PIN 15
+
+#define LCD_SDA_PIN 25 // LCD SDA
+#define LCD_SCL_PIN 26 // LCD SCL
+
+#include <shadow_lcd.hpp>
+
+#define MAX_FEEDBACK_SCREENS 4 // Screens in one entry/exit/admin feedback sequence
+
+#define ATTENDANCE_LOG_CAPACITY 256  // Attendance events buffered for export
+#define ATTENDANCE_BATCH_EVENTS 16   // Events that trigger sending a frame
+#define ATTENDANCE_FLUSH_MS 30000    // Longest time an event waits before it is sent
+
+#define ROSTER_PATH "/roster"           // Roster file imported at boot
+#define ROSTER_DONE_PATH "/roster.done" // Where it is moved once imported
+#define ROSTER_SPOOL_PATH "/roster.spool" // Serial roster being received
+
+#define SCAN_QUEUE_SIZE 16 // Scans buffered between the reader task and loop(), power of two
+#define READER_CORE 0      // Core the reader task is pinned to; loop() runs on core 1
+#define MAX_READERS 4      // RFID readers sharing the SPI bus, each on its own chip select
+#define REREAD_WINDOW_MS 3000 // Reads of the same card closer together than this are dropped
+#define REREAD_CACHE_SIZE 8    // Distinct cards the re-read filter remembers
+
+#define DENIED_CACHE_SLOTS 32  // Recently denied cards remembered, power of two
+#define DENIED_CACHE_MS 60000  // How long a denied card is answered from the cache
+#define DENIED_WINDOW_MS 10000 // Rate limiting window for denial feedback
+#define DENIED_FEEDBACK_MAX 3  // Denials per window that get the melody and screen
+
+#define SENSOR_CORE 0              // Core the DHT sampler task is pinned to
+#define CLIMATE_SAMPLE_MS 2000     // DHT sampling period, the DHT11's minimum interval
+#define CLIMATE_WINDOW_SAMPLES 150 // Samples in the rolling climate window (5 minutes)
+#define CLIMATE_MAX_AGE_MS 30000   // Oldest reading still recorded with a scan
+
+#define CLOCK_RESYNC_MS 600000 // How often the software clock is resynced from the RTC
+
+#define ADMIN_UID "53F7CA0E"
+
+#define JOYSTICK_SAMPLE_MS 10   // Joystick sampling period
+#define JOYSTICK_REPEAT_MS 1000 // Repeat period while left or right is held
+#define JOYSTICK_QUEUE_SIZE 8   // Joystick events buffered for the menu, power of two
+
+#define DHTPIN 13     // Pin connected to the DHT11 sensor
+#define DHTTYPE DHT11 // Define the type of DHT sensor
+
+// UID of the card that toggles admin mode
+constexpr CardUid adminUid = cardUidFromHex(ADMIN_UID);
+
+#define SECONDS_PER_HOUR 3600u
+#define SECONDS_PER_DAY 86400u
+
+// Buffer sizes for the formatting helpers, including the terminator. They write into
+// caller-owned buffers so no scan or screen ever touches the heap.
+#define TIME_STRING_SIZE 20 // "MM/DD/YYYY HH:MM:SS"
+#define SPENT_TIME_SIZE 20  // "HHh:MMm:SSs", hours may run to more digits
+#define DATE_SPAN_SIZE 20   // "DDd:HHh:MMm:SSs"
+
+// Point in time as seconds since 2000-01-01 00:00:00 (the RtcDateTime epoch).
+// 32 bits cover the DS1302's whole 2000-2099 range; 0 means "never".
+typedef uint32_t EpochTime;
+
+// Number of 32-bit words needed for a bitset of `bits` bits
+#define BITSET_WORDS(bits) (((bits) + 31) / 32)
+
+#define SESSION_EWMA_WEIGHT 4 // Sessions the moving average of session length roughly spans
+
+// Running aggregates of a member's sessions, updated in O(1) as each session ends.
+// The week and month totals belong to the period stored with them; a session ending in a
+// later period starts them over, and a period that has passed without one reads as zero.
+struct sessionStats
+{
+    uint16_t week;           // Weeks since Monday 2000-01-03
+    uint16_t month;          // Months since January 2000
+    uint16_t weekSessions;
+    uint16_t monthSessions;
+    uint32_t weekSeconds;
+    uint32_t monthSeconds;
+    uint32_t sessions;       // Since the member was enrolled
+    uint32_t averageSeconds; // Moving average, weighted 1 / SESSION_EWMA_WEIGHT per session
+    uint32_t minSeconds;
+    uint32_t maxSeconds;
+};
+
+// Member table, split by how often each field is touched.
+// Hot data read on every scan (UIDs, access and presence flags) lives in dense arrays and
+// bitsets indexed by member number; names and timestamps, only needed when a screen shows
+// them or a session ends, live in details_db.
+struct memberDetails
+{
+    char name[STORED_NAME_SIZE];
+    EpochTime lastLogTime;
+    int lastTimeSpent;
+    sessionStats stats;
+};
+
+// Event counter bumped by one task or timer and read from another core. Relaxed ordering
+// is enough: each count stands alone, it only has to be read whole.
+class SharedCounter
+{
+public:
+    constexpr SharedCounter() : value(0) {}
+    void increment() { value.fetch_add(1, std::memory_order_relaxed); }
+    unsigned long get() const { return value.load(std::memory_order_relaxed); }
+    operator unsigned long() const { return get(); }
+
+private:
+    std::atomic<unsigned long> value;
+};
+
+// Discrete joystick input produced by the joystick driver
+enum JoystickEvent : uint8_t
+{
+    JOYSTICK_LEFT,
+    JOYSTICK_RIGHT,
+    JOYSTICK_SELECT, // Pushed down
+    JOYSTICK_BACK    // Pushed up
+};
+
+// What a scan on a reader means for the member
+enum ReaderRole : uint8_t
+{
+    READER_TOGGLE, // Enters a member who is out and exits one who is in
+    READER_ENTRY,
+    READER_EXIT
+};
+
+// An RFID reader on the shared SPI bus
+struct ReaderConfig
+{
+    uint8_t chipSelectPin;
+    ReaderRole role;
+    const char *name;
+};
+
+// Reader counters since boot, bumped by the reader task and read from loop()
+struct ReaderCounters
+{
+    SharedCounter polls; // Polls for a new card
+    SharedCounter scans; // Cards read
+};
+
+// A card read by the reader task, queued for loop()
+struct ScanEvent
+{
+    CardUid uid;
+    unsigned long readAt; // millis() when the card was read
+    uint8_t reader;       // Index into readerConfigs of the reader that read it
+#if LATENCY_PROBES
+    uint32_t detectedAtUs; // micros() when the poll that found the card started
+    uint32_t readAtUs;     // micros() when it was read
+#endif
+};
+
+// Denied card counters since boot
+struct DenialStats
+{
+    unsigned long denied;  // Scans of unknown or revoked cards
+    unsigned long cached;  // Of those, answered from the negative cache
+    unsigned long limited; // Of those, cut short by the rate limit (no melody or screen)
+};
+
+// Software clock counters since boot
+struct ClockStats
+{
+    unsigned long syncs;   // RTC reads after the one at boot
+    unsigned long invalid; // RTC reads that found it without a valid time
+    long lastOffset;       // RTC minus software clock at the last good resync, in seconds
+};
+
+// Minimum, maximum and mean over the rolling climate window
+struct ClimateStats
+{
+    float min;
+    float max;
+    float mean;
+};
+
+// Climate snapshot published by the DHT sampler task
+struct ClimateReading
+{
+    float temperature;     // Last valid reading, NAN before the first one
+    float humidity;
+    unsigned long takenAt; // millis() of the last valid reading
+    ClimateStats temperatureStats;
+    ClimateStats humidityStats;
+    int samples;            // Valid readings in the window
+    unsigned long failures; // Failed reads since boot
+};
+
+// Per-member RAM in bytes: the UID, two flag bits and its share of the 4-byte index slots,
+// then the cold details
+#define MEMBER_HOT_BYTES (sizeof(CardUid) + 2.0 / 8 + 4.0 * BadgeScanner::indexSlots / MAX_UIDS)
+#define MEMBER_COLD_BYTES (sizeof(memberDetails))
+
+// Extern declarations for global variables
+extern ReaderConfig readerConfigs[MAX_READERS];
+extern int readerCount;
+extern ReaderCounters readerCounters[MAX_READERS];
+extern LiquidCrystal_I2C lcdDevice;
+extern ShadowLCD lcd;
+extern CardUid memberUids[MAX_UIDS];
+extern uint32_t memberAccessBits[BITSET_WORDS(MAX_UIDS)];
+extern uint32_t memberLoggedBits[BITSET_WORDS(MAX_UIDS)];
+extern memberDetails details_db[MAX_UIDS];
+extern int uidCount;
+extern int currentMemberIndex;
+extern int occupancyCount;
+extern unsigned long attendanceDropped;
+extern SharedCounter scansDropped;
+extern SharedCounter scansSuppressed;
+extern SharedCounter joystickEventsDropped;
+extern DenialStats denialStats;
+extern ClockStats clockStats;
+extern BadgeScanner::Index memberIndex;
+extern ThreeWire myWire;
+extern RtcDS1302<ThreeWire> Rtc;
+extern DHT dht;
+
+// Bitset helpers for the member flags
+inline bool bitsetTest(const uint32_t *bits, int index)
+{
+    return bits[index >> 5] & (1u << (index & 31));
+}
+
+inline void bitsetAssign(uint32_t *bits, int index, bool value)
+{
+    if (value)
+        bits[index >> 5] |= 1u << (index & 31);
+    else
+        bits[index >> 5] &= ~(1u << (index & 31));
+}
+
+inline bool memberHasAccess(int index) { return bitsetTest(memberAccessBits, index); }
+inline bool memberLogged(int index) { return bitsetTest(memberLoggedBits, index); }
+
+// Function declarations
+EpochTime toEpochTime(const RtcDateTime &dt);
+char *epochToString(EpochTime time, char *out, size_t size);
+void printStringOnLCD(const char *message);
+CardUid convertUID(const MFRC522::Uid &readerUid);
+int uidToIndex(const CardUid &uid);
+MemberLookup lookupMember(const CardUid &uid);
+MemberLookup checkMemberAccess(const CardUid &uid);
+bool allowDenialFeedback();
+void forgetDeniedCards();
+void buildMemberIndex();
+void setMemberAccess(int index, bool hasAccess);
+void setMemberLogged(int index, bool logged, EpochTime timestamp);
+void initOccupancy();
+void occupancyAdvance(EpochTime timestamp);
+void recordOccupancyChange(int delta, EpochTime timestamp);
+void getOccupancyHour(int hour, int &peak, float &average);
+int currentOccupancyHour();
+bool cryptoSelfTest();
+void startCrypto();
+const char *cryptoBackend();
+bool sealRecords(const uint8_t *nonce, const uint8_t *aad, size_t aadLength, uint8_t *data, size_t length,
+                 uint8_t *tag);
+bool openRecords(const uint8_t *nonce, const uint8_t *aad, size_t aadLength, uint8_t *data, size_t length,
+                 const uint8_t *tag);
+void printCryptoThroughput();
+void logAttendanceEvent(EpochTime time, int member, uint8_t kind, float temperature, float humidity);
+void flushAttendanceLog(bool force);
+void startReaders();
+void startReaderTask();
+bool nextScan(ScanEvent &scan);
+void startJoystick();
+bool nextJoystickEvent(JoystickEvent &event);
+void discardJoystickEvents();
+void printMemberFootprint();
+bool loadMembers();
+bool saveMembers();
+void storeMember(int index);
+bool importRosterFile(const char *path);
+void startRosterSerial();
+bool rosterImportActive();
+void pollRosterSerial();
+void pollConsole();
+int grantCardAccess(const CardUid &newUID, const char *name, bool &enrolled);
+void addCardAccess(const CardUid &newUID);
+void removeCardAccess(const CardUid &removeUID);
+void showTotalNumber();
+float calculateTimeSpentPercentage(int lastTimeSpent, int currentTimeSpent);
+char *formatSpentTime(int totalSeconds, char *out, size_t size);
+RtcDateTime readQuartzTime();
+void setDateTime();
+void startClock();
+void updateClock();
+EpochTime clockNow();
+RtcDateTime clockDateTime();
+void recordSession(int index, const RtcDateTime &end, int seconds);
+sessionStats currentSessionStats(int index, const RtcDateTime &now);
+void printSessionStats(int index, const RtcDateTime &now);
+char *formatDuration(uint32_t seconds, char *out, size_t size);
+void displayExitTime(RtcDateTime now, int index);
+void printIdle();
+char *timeToString(const RtcDateTime &dt, char *out, size_t size);
+bool isAuthorizedUID(const CardUid &uid);
+void turnOffLEDs();
+void goodbyeMelody();
+void adminGoodbyeMelody();
+void adminAccessMelody();
+void accessGrantedMelody();
+void accessDeniedMelody();
+void setupLEDControl();
+void startClimateSampler();
+void updateClimate();
+const ClimateReading &currentClimate();
+void printClimateStats();
+void get_temperature_humidity(float &temperature, float &humidity);
+void print_temperature_humidity(float temperature, float humidity);
+void turnOffLedsAndBuzzer();
+char *intToDate(int seconds, char *out, size_t size);
+void updateReceived();
+void waitForJoystickUp();
+void startFeedback();
+void addFeedbackScreen(const char *line1, const char *line2, unsigned long duration);
+bool updateFeedback();
+
+#endif // UTILS_HPP
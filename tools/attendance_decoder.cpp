@@ -0,0 +1,165 @@
+// Host-side decoder for the scanner's attendance frames.
+//
+// Reads the raw serial stream (a capture file, or stdin when no file is given), picks
+// the binary frames out of the interleaved text log, checks their CRC, decrypts and
+// authenticates them with the export key and prints one CSV line per event:
+//
+//   sequence,time,member,kind,temperature,humidity
+//
+// Lost or corrupt frames, and frames that fail authentication, are reported on stderr.
+// Unauthenticated version 1 frames are counted and skipped: a forged one would only need
+// a valid CRC. --accept-plain decodes them, for captures from firmware that predates
+// sealing.
+//
+// Build: g++ -std=c++17 -O2 -Isrc tools/attendance_decoder.cpp -o attendance_decoder
+// Usage: attendance_decoder [--key HEX] [--accept-plain] [capture.bin] > events.csv
+//        The key defaults to the development ATTENDANCE_KEY_HEX.
+
+#include <attendance_frame.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+// Seconds between the Unix epoch and the scanner's 2000-01-01 epoch
+static const time_t scannerEpochOffset = 946684800;
+
+static AesGcm exportKey;
+
+static bool openFrame(const uint8_t *nonce, const uint8_t *aad, size_t aadLength, uint8_t *data, size_t length,
+                      const uint8_t *tag)
+{
+    return exportKey.open(nonce, aad, aadLength, data, length, tag);
+}
+
+static void printEvent(uint16_t sequence, const AttendanceEvent &event)
+{
+    time_t unixTime = (time_t)event.time + scannerEpochOffset;
+    struct tm utc;
+    gmtime_r(&unixTime, &utc);
+    char timeText[32];
+    strftime(timeText, sizeof(timeText), "%Y-%m-%d %H:%M:%S", &utc);
+
+    printf("%u,%s,%u,%s,", sequence, timeText, event.member,
+           event.kind == ATTENDANCE_ENTRY  ? "entry"
+           : event.kind == ATTENDANCE_EXIT ? "exit"
+                                           : "unknown");
+    if (event.temperature != ATTENDANCE_NO_TEMPERATURE)
+        printf("%.2f,", event.temperature / 100.0);
+    else
+        printf(",");
+    if (event.humidity != ATTENDANCE_NO_HUMIDITY)
+        printf("%u\n", event.humidity);
+    else
+        printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *keyHex = ATTENDANCE_KEY_HEX;
+    const char *path = nullptr;
+    bool acceptPlain = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--key") == 0 && i + 1 < argc)
+            keyHex = argv[++i];
+        else if (strcmp(argv[i], "--accept-plain") == 0)
+            acceptPlain = true;
+        else
+            path = argv[i];
+    }
+
+    uint8_t key[AES_KEY_BYTES];
+    if (!parseAesKey(keyHex, key))
+    {
+        fprintf(stderr, "key must be %d hex digits\n", AES_KEY_BYTES * 2);
+        return 1;
+    }
+    exportKey.setKey(key);
+
+    FILE *input = stdin;
+    if (path && !(input = fopen(path, "rb")))
+    {
+        perror(path);
+        return 1;
+    }
+
+    std::vector<uint8_t> buffer;
+    size_t start = 0;
+    bool haveSequence = false;
+    uint16_t expected = 0;
+    unsigned long frames = 0, events = 0, corrupt = 0, lost = 0, plain = 0;
+
+    printf("sequence,time,member,kind,temperature,humidity\n");
+
+    uint8_t chunk[4096];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), input)) > 0)
+    {
+        buffer.insert(buffer.end(), chunk, chunk + read);
+
+        // Scan for frames; anything that is not a valid frame is text log and is skipped
+        while (buffer.size() - start >= ATTENDANCE_HEADER_BYTES)
+        {
+            size_t length = attendanceFrameLength(&buffer[start]);
+            if (length == 0)
+            {
+                start++;
+                continue;
+            }
+            if (buffer.size() - start < length)
+            {
+                break; // Wait for the rest of the frame
+            }
+
+            AttendanceEvent batch[ATTENDANCE_FRAME_MAX_EVENTS];
+            uint16_t sequence;
+            uint8_t count = decodeAttendanceFrame(&buffer[start], length, batch, sequence, openFrame, acceptPlain);
+            if (count == 0)
+            {
+                if (buffer[start + 2] == ATTENDANCE_FRAME_PLAIN_VERSION && !acceptPlain)
+                    plain++;
+                else
+                    corrupt++;
+                start++; // Resynchronise on the next sync pattern
+                continue;
+            }
+
+            if (haveSequence && sequence != expected)
+            {
+                uint16_t gap = sequence - expected;
+                lost += gap;
+                fprintf(stderr, "frames %u..%u lost\n", expected, (uint16_t)(sequence - 1));
+            }
+            haveSequence = true;
+            expected = sequence + 1;
+
+            for (uint8_t i = 0; i < count; i++)
+            {
+                printEvent(sequence, batch[i]);
+            }
+            frames++;
+            events += count;
+            start += length;
+        }
+
+        // Drop consumed bytes now and then so the buffer stays small
+        if (start > sizeof(chunk))
+        {
+            buffer.erase(buffer.begin(), buffer.begin() + start);
+            start = 0;
+        }
+    }
+
+    fprintf(stderr, "%lu frames, %lu events, %lu corrupt, %lu lost frames\n", frames, events, corrupt, lost);
+    if (plain > 0)
+    {
+        fprintf(stderr, "%lu unauthenticated version 1 frames skipped, use --accept-plain to decode them\n", plain);
+    }
+    if (input != stdin)
+    {
+        fclose(input);
+    }
+    return 0;
+}
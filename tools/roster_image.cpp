@@ -0,0 +1,69 @@
+// Host-side packer for roster images.
+//
+// Reads a CSV roster (a file, or stdin when no input is given), in the format described
+// in src/roster_format.hpp, and writes the equivalent compact binary image. Either form
+// can be copied to the scanner's flash as /roster or sent over serial after a "roster"
+// line; the binary one is smaller and CRC-protected as a whole.
+//
+// Build: g++ -std=c++17 -O2 -Isrc tools/roster_image.cpp -o roster_image
+// Usage: roster_image [roster.csv] > roster.bin
+
+#include <roster_format.hpp>
+
+#include <cstdio>
+#include <vector>
+
+static void collect(const RosterRecord &record, void *context)
+{
+    ((std::vector<RosterRecord> *)context)->push_back(record);
+}
+
+int main(int argc, char **argv)
+{
+    FILE *input = stdin;
+    if (argc > 1 && !(input = fopen(argv[1], "rb")))
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    std::vector<RosterRecord> records;
+    RosterParser parser(collect, &records);
+    uint8_t chunk[4096];
+    size_t read;
+    while (!parser.done() && (read = fread(chunk, 1, sizeof(chunk), input)) > 0)
+    {
+        parser.feed(chunk, read);
+    }
+    if (input != stdin)
+    {
+        fclose(input);
+    }
+    if (!parser.finish() || parser.binary())
+    {
+        fprintf(stderr, "input is not a CSV roster\n");
+        return 1;
+    }
+
+    uint8_t header[ROSTER_HEADER_BYTES];
+    encodeRosterHeader(records.size(), header);
+    fwrite(header, 1, sizeof(header), stdout);
+    uint32_t crc = crc32(header + 4, sizeof(header) - 4);
+
+    size_t bytes = sizeof(header) + ROSTER_CRC_BYTES;
+    for (const RosterRecord &record : records)
+    {
+        uint8_t encoded[ROSTER_RECORD_MAX_BYTES];
+        size_t length = encodeRosterRecord(record, encoded);
+        fwrite(encoded, 1, length, stdout);
+        crc = crc32(encoded, length, crc);
+        bytes += length;
+    }
+
+    uint8_t trailer[ROSTER_CRC_BYTES];
+    encodeRosterCrc(crc, trailer);
+    fwrite(trailer, 1, sizeof(trailer), stdout);
+
+    fprintf(stderr, "%zu members, %lu bad lines skipped, %zu bytes\n", records.size(), parser.rejected(), bytes);
+    return 0;
+}